@@ -0,0 +1,386 @@
+#include "batchheaderio.h"
+#include "pagecachehints.h"
+#include <QFile>
+#include <QMutex>
+#include <QVarLengthArray>
+#include <memory>
+#include <vector>
+
+#if defined(Q_OS_LINUX) && __has_include(<linux/io_uring.h>)
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <cerrno>
+#  include <cstring>
+// IORING_OP_OPENAT/READ/CLOSE arrived with IORING_FEAT_RW_CUR_POS (5.6).
+#  if defined(__NR_io_uring_setup) && defined(IORING_FEAT_RW_CUR_POS)
+#    define HAVE_IO_URING 1
+#  endif
+#endif
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+// Portable path: opens up to kQueueDepth files, announces all their
+// prefixes to the kernel, then reads them one after another.  With hints
+// enabled the kernel fetches the later prefixes while the first are read.
+static void readWithQFile(const QStringList &paths, qint64 bytes,
+                          QList<QByteArray> &out)
+{
+    const qsizetype batch = BatchHeaderIo::kQueueDepth;
+    for (qsizetype first = 0; first < paths.size(); first += batch) {
+        const qsizetype count = qMin(batch, paths.size() - first);
+        std::vector<std::unique_ptr<QFile>> files;
+        files.reserve(size_t(count));
+        for (qsizetype i = 0; i < count; ++i) {
+            auto f = std::make_unique<QFile>(paths.at(first + i));
+            if (f->open(QIODevice::ReadOnly)) {
+                PageCacheHints::randomAccess(f->handle());
+                PageCacheHints::willNeed(f->handle(), 0, bytes);
+            }
+            files.push_back(std::move(f));
+        }
+        for (qsizetype i = 0; i < count; ++i) {
+            QFile &f = *files[size_t(i)];
+            if (!f.isOpen()) continue;
+            out[first + i] = f.read(bytes);
+            PageCacheHints::dontNeed(f.handle(), 0, bytes);
+        }
+    }
+}
+
+#ifdef HAVE_IO_URING
+
+// Reads the first bytes of path with QFile; empty on failure.
+static QByteArray readPrefix(const QString &path, qint64 bytes)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return {};
+    PageCacheHints::randomAccess(f.handle());
+    const QByteArray data = f.read(bytes);
+    PageCacheHints::dontNeed(f.handle(), 0, bytes);
+    return data;
+}
+
+// ── Minimal io_uring ──────────────────────────────────────────────────────
+//
+// One submission queue and one completion queue, both mapped from the
+// ring fd.  Only this thread produces submissions and consumes
+// completions; the kernel is the other side of each ring.
+class IoUring {
+public:
+    explicit IoUring(unsigned entries)
+    {
+        io_uring_params p;
+        std::memset(&p, 0, sizeof p);
+        m_fd = int(syscall(__NR_io_uring_setup, entries, &p));
+        if (m_fd < 0) return;
+
+        m_sqRingBytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        m_cqRingBytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single)
+            m_sqRingBytes = m_cqRingBytes =
+                qMax(m_sqRingBytes, m_cqRingBytes);
+
+        m_sqRing = mapRing(m_sqRingBytes, IORING_OFF_SQ_RING);
+        m_cqRing = single ? m_sqRing
+                          : mapRing(m_cqRingBytes, IORING_OFF_CQ_RING);
+        m_sqesBytes = p.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe *>(
+            mapRing(m_sqesBytes, IORING_OFF_SQES));
+        if (!m_sqRing || !m_cqRing || !m_sqes) {
+            release();
+            return;
+        }
+
+        char *sq = static_cast<char *>(m_sqRing);
+        char *cq = static_cast<char *>(m_cqRing);
+        m_sqTail  = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+        m_sqMask  = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+        m_cqHead  = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+        m_cqTail  = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+        m_cqMask  = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+        m_cqes    = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+        m_entries = p.sq_entries;
+    }
+
+    ~IoUring() { release(); }
+
+    bool isValid() const { return m_fd >= 0; }
+    unsigned entries() const { return m_entries; }
+
+    // A zeroed submission slot; published by submitAndWait().
+    io_uring_sqe *next()
+    {
+        const unsigned tail = *m_sqTail + m_pending;
+        const unsigned idx  = tail & m_sqMask;
+        io_uring_sqe *sqe = &m_sqes[idx];
+        std::memset(sqe, 0, sizeof *sqe);
+        m_sqArray[idx] = idx;
+        ++m_pending;
+        return sqe;
+    }
+
+    // Submits everything queued by next() and calls done(user_data, res)
+    // for each completion.  False if the ring failed.  Even then, every
+    // request the kernel accepted has completed and been passed to done
+    // before it returns, unless waiting for them failed too (stranded()),
+    // and requests it had not accepted are withdrawn.
+    template <typename Done>
+    bool submitAndWait(Done done)
+    {
+        const unsigned count = m_pending;
+        __atomic_store_n(m_sqTail, *m_sqTail + count, __ATOMIC_RELEASE);
+        m_pending  = 0;
+        m_stranded = 0;
+
+        unsigned submitted = 0, completed = 0;
+        bool failed = false;
+        while (completed < (failed ? submitted : count)) {
+            const unsigned toSubmit = failed ? 0 : count - submitted;
+            const int r = int(syscall(__NR_io_uring_enter, m_fd, toSubmit, 1,
+                                      IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (r >= 0) {
+                submitted += unsigned(r);
+            } else if (errno != EINTR && errno != EBUSY) {
+                if (failed) {
+                    m_stranded = submitted - completed;
+                    return false;
+                }
+                // Nothing runs the queue between calls (no SQPOLL), so
+                // the entries the kernel has not consumed can be taken
+                // back; the ones it has must still be waited for.
+                failed = true;
+                __atomic_store_n(m_sqTail, *m_sqTail - (count - submitted),
+                                 __ATOMIC_RELEASE);
+            }
+
+            unsigned head = *m_cqHead;
+            const unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head, ++completed) {
+                const io_uring_cqe &cqe = m_cqes[head & m_cqMask];
+                done(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        }
+        return !failed;
+    }
+
+    // Requests that may still be in flight after submitAndWait() failed.
+    // The kernel can still write into their buffers.
+    unsigned stranded() const { return m_stranded; }
+
+private:
+    void *mapRing(size_t bytes, off_t offset)
+    {
+        void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, m_fd, offset);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    void release()
+    {
+        if (m_sqes) munmap(m_sqes, m_sqesBytes);
+        if (m_cqRing && m_cqRing != m_sqRing) munmap(m_cqRing, m_cqRingBytes);
+        if (m_sqRing) munmap(m_sqRing, m_sqRingBytes);
+        if (m_fd >= 0) close(m_fd);
+        m_sqes = nullptr;
+        m_sqRing = m_cqRing = nullptr;
+        m_fd = -1;
+    }
+
+    int           m_fd{-1};
+    void         *m_sqRing{nullptr};
+    void         *m_cqRing{nullptr};
+    io_uring_sqe *m_sqes{nullptr};
+    size_t        m_sqRingBytes{0};
+    size_t        m_cqRingBytes{0};
+    size_t        m_sqesBytes{0};
+    unsigned     *m_sqTail{nullptr};
+    unsigned     *m_sqArray{nullptr};
+    unsigned      m_sqMask{0};
+    unsigned     *m_cqHead{nullptr};
+    unsigned     *m_cqTail{nullptr};
+    io_uring_cqe *m_cqes{nullptr};
+    unsigned      m_cqMask{0};
+    unsigned      m_entries{0};
+    unsigned      m_pending{0};
+    unsigned      m_stranded{0};
+};
+
+// Keeps data alive for good.  Used for the buffers of requests the kernel
+// may still complete after the ring failed, which must never be freed.
+static void abandon(const QByteArray &data)
+{
+    static QMutex            mutex;
+    static QList<QByteArray> *kept = new QList<QByteArray>;
+    QMutexLocker lk(&mutex);
+    kept->append(data);
+}
+
+// One batch of at most ring.entries() files: all opens, then all reads,
+// then all closes, each phase in flight at once.  Files whose open or
+// read failed for any reason other than not existing are left empty with
+// retry set, to be read with QFile.  False if the ring failed; every file
+// the batch opened is closed by then, and out is safe to release.
+static bool readBatch(IoUring              &ring,
+                      const QStringList    &paths,
+                      qsizetype             first,
+                      qsizetype             count,
+                      qint64                bytes,
+                      QList<QByteArray>    &out,
+                      QVarLengthArray<bool, BatchHeaderIo::kQueueDepth> &retry)
+{
+    QVarLengthArray<QByteArray, BatchHeaderIo::kQueueDepth> names(count);
+    QVarLengthArray<int, BatchHeaderIo::kQueueDepth>        fds(count);
+    retry.fill(false);
+
+    const auto closeAll = [&]() {
+        for (qsizetype i = 0; i < count; ++i)
+            if (fds[i] >= 0) ::close(fds[i]);
+    };
+
+    for (qsizetype i = 0; i < count; ++i) {
+        names[i] = QFile::encodeName(paths.at(first + i));
+        fds[i]   = -1;
+        io_uring_sqe *sqe = ring.next();
+        sqe->opcode     = IORING_OP_OPENAT;
+        sqe->fd         = AT_FDCWD;
+        sqe->addr       = reinterpret_cast<quint64>(names[i].constData());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data  = quint64(i);
+    }
+    bool ok = ring.submitAndWait([&](quint64 i, int res) {
+        if (res >= 0)            fds[i] = res;
+        else if (res != -ENOENT) retry[i] = true;
+    });
+    if (!ok) {
+        // Opens still in flight read the names, and may yet return a
+        // descriptor nobody will close.
+        if (ring.stranded() > 0)
+            for (const QByteArray &name : std::as_const(names))
+                abandon(name);
+        closeAll();
+        return false;
+    }
+
+    // The reads below are all in flight at once, so WILLNEED would add
+    // nothing; RANDOM still stops readahead into the pixel data.
+    for (qsizetype i = 0; i < count; ++i)
+        PageCacheHints::randomAccess(fds[i]);
+
+    qsizetype reads = 0;
+    for (qsizetype i = 0; i < count; ++i) {
+        if (fds[i] < 0) continue;
+        QByteArray &buf = out[first + i];
+        buf.resize(bytes);
+        io_uring_sqe *sqe = ring.next();
+        sqe->opcode    = IORING_OP_READ;
+        sqe->fd        = fds[i];
+        sqe->addr      = reinterpret_cast<quint64>(buf.data());
+        sqe->len       = unsigned(bytes);
+        sqe->off       = 0;
+        sqe->user_data = quint64(i);
+        ++reads;
+    }
+    if (reads > 0)
+        ok = ring.submitAndWait([&](quint64 i, int res) {
+            QByteArray &buf = out[first + qsizetype(i)];
+            if (res >= 0 && res < buf.size()) buf.truncate(res);
+            if (res < 0) {
+                buf.clear();
+                retry[i] = true;
+            }
+        });
+    if (!ok) {
+        // A read the kernel still holds writes into its buffer whenever it
+        // completes; keep every buffer of the batch alive rather than
+        // guess which.
+        if (ring.stranded() > 0)
+            for (qsizetype i = 0; i < count; ++i)
+                if (fds[i] >= 0) abandon(out[first + i]);
+        closeAll();
+        return false;
+    }
+
+    qsizetype closes = 0;
+    for (qsizetype i = 0; i < count; ++i) {
+        if (fds[i] < 0) continue;
+        PageCacheHints::dontNeed(fds[i], 0, bytes);
+        io_uring_sqe *sqe = ring.next();
+        sqe->opcode    = IORING_OP_CLOSE;
+        sqe->fd        = fds[i];
+        sqe->user_data = quint64(i);
+        ++closes;
+    }
+    if (closes > 0) {
+        ok = ring.submitAndWait([&](quint64 i, int) { fds[i] = -1; });
+        // Closes the kernel never took are done here.
+        if (!ok && ring.stranded() == 0) closeAll();
+    }
+    return ok;
+}
+
+static bool readWithIoUring(const QStringList &paths, qint64 bytes,
+                            QList<QByteArray> &out)
+{
+    IoUring ring(BatchHeaderIo::kQueueDepth);
+    if (!ring.isValid()) return false;
+
+    const qsizetype batch = qsizetype(ring.entries());
+    QVarLengthArray<bool, BatchHeaderIo::kQueueDepth> retry(batch);
+    for (qsizetype first = 0; first < paths.size(); first += batch) {
+        const qsizetype count = qMin(batch, paths.size() - first);
+        retry.resize(count);
+        if (!readBatch(ring, paths, first, count, bytes, out, retry))
+            return false;
+        // Older kernels reject the opcodes with EINVAL; those files, and
+        // any other failure, get a second chance through QFile.
+        for (qsizetype i = 0; i < count; ++i)
+            if (retry[i])
+                out[first + i] = readPrefix(paths.at(first + i), bytes);
+    }
+    return true;
+}
+
+static bool ioUringWorks()
+{
+    static const bool works = IoUring(1).isValid();
+    return works;
+}
+
+#endif // HAVE_IO_URING
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+bool BatchHeaderIo::usesIoUring()
+{
+#ifdef HAVE_IO_URING
+    return ioUringWorks();
+#else
+    return false;
+#endif
+}
+
+QList<QByteArray> BatchHeaderIo::readPrefixes(const QStringList &paths,
+                                              qint64             bytes)
+{
+    QList<QByteArray> out(paths.size());
+    if (bytes <= 0 || paths.isEmpty()) return out;
+
+#ifdef HAVE_IO_URING
+    if (ioUringWorks() && readWithIoUring(paths, bytes, out))
+        return out;
+    out.fill(QByteArray());
+#endif
+
+    readWithQFile(paths, bytes, out);
+    return out;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <QByteArray>
+#include <QList>
+#include <QStringList>
+
+// ── BatchHeaderIo ─────────────────────────────────────────────────────────
+//
+// Reads the first bytes of many files at once, so header resolution keeps
+// the disk or NAS busy with many requests in flight from one thread
+// instead of waiting on one open/read/close after another.
+//
+// On Linux the opens, reads and closes of a batch are submitted through
+// io_uring, up to kQueueDepth at a time.  It is driven with raw syscalls
+// against the kernel UAPI header, so there is no library dependency.
+// Where io_uring is unavailable (other platforms, kernels before 5.6,
+// seccomp-filtered containers), a batch is opened first and announced
+// with PageCacheHints::willNeed, then read one file after another with
+// QFile.
+// ─────────────────────────────────────────────────────────────────────────
+class BatchHeaderIo {
+public:
+    static constexpr unsigned kQueueDepth = 64;
+
+    // The first bytes of each path, in order.  An entry is empty if the
+    // file could not be read; callers then read it the normal way, which
+    // also reports the error.
+    static QList<QByteArray> readPrefixes(const QStringList &paths,
+                                          qint64             bytes);
+
+    // True if readPrefixes() uses io_uring in this process.
+    static bool usesIoUring();
+};
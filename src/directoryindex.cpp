@@ -0,0 +1,107 @@
+#include "directoryindex.h"
+#include "directorywalker.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+// File names match the way the platform's default file systems compare
+// them, as QDir::exists() did for the directory walk this replaces.
+static QString key(const QString &fileName)
+{
+#if defined(Q_OS_WIN) || defined(Q_OS_DARWIN)
+    return fileName.toCaseFolded();
+#else
+    return fileName;
+#endif
+}
+
+static QString cleanRoot(const QString &root)
+{
+    return QDir::cleanPath(QFileInfo(root).absoluteFilePath());
+}
+
+static bool within(const QString &path, const QString &dir)
+{
+    return path == dir
+        || (path.startsWith(dir)
+            && (dir.endsWith(QLatin1Char('/'))
+                || path.at(dir.size()) == QLatin1Char('/')));
+}
+
+// Indexes the tree under root.  A name already indexed keeps its earlier
+// path.  False if cancelled.
+static bool enumerate(const QString &root, QHash<QString, QString> &names,
+                      QAtomicInt *cancel)
+{
+    return DirectoryWalker::walk(
+        root, DirectoryIndex::kMaxDepth, cancel,
+        [&names](const QString &dir, const QStringList &entries) {
+            const QString prefix = dir.endsWith(QLatin1Char('/'))
+                                       ? dir : dir + QLatin1Char('/');
+            for (const QString &name : entries) {
+                const QString k = key(name);
+                if (!names.contains(k))
+                    names.insert(k, prefix + name);
+            }
+        });
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+QString DirectoryIndex::find(const QString &root, const QString &fileName,
+                             QAtomicInt *cancel)
+{
+    if (root.isEmpty() || fileName.isEmpty()) return {};
+    const QString r = cleanRoot(root);
+
+    // Held while a root is enumerated, so a second lookup of the same root
+    // waits for the index instead of walking it again.
+    QMutexLocker lk(&m_mutex);
+    auto it = m_roots.find(r);
+    if (it == m_roots.end()) {
+        Names names;
+        if (!enumerate(r, names, cancel)) return {};
+        it = m_roots.insert(r, std::move(names));
+    }
+    return it->value(key(fileName));
+}
+
+void DirectoryIndex::refresh(const QString &dir)
+{
+    if (dir.isEmpty()) return;
+    const QString d = cleanRoot(dir);
+
+    QMutexLocker lk(&m_mutex);
+    for (auto it = m_roots.begin(); it != m_roots.end();) {
+        if (within(it.key(), d) || within(d, it.key()))
+            it = m_roots.erase(it);
+        else
+            ++it;
+    }
+}
+
+void DirectoryIndex::clear()
+{
+    QMutexLocker lk(&m_mutex);
+    m_roots.clear();
+}
+
+int DirectoryIndex::rootCount() const
+{
+    QMutexLocker lk(&m_mutex);
+    return int(m_roots.size());
+}
+
+qint64 DirectoryIndex::entryCount() const
+{
+    QMutexLocker lk(&m_mutex);
+    qint64 n = 0;
+    for (const Names &names : m_roots) n += names.size();
+    return n;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+// ── DirectoryIndex ────────────────────────────────────────────────────────
+//
+// File name → path index of the directory trees searched for missing
+// frames and masters.  Each root is enumerated once by DirectoryWalker, up
+// to kMaxDepth levels below it, the first time a file is looked up there.
+// Every later lookup in that root is a hash lookup instead of another walk.
+//
+// A lookup returns the match a depth-first search would find first: a
+// directory's own entries before its subdirectories, and subdirectories
+// in name order.  Hidden directories are not entered.
+//
+// One instance is shared by the registered, calibrated and master tiers
+// of an import and by MainWindow's prompts and back-fill.  It is
+// thread-safe.  When the user supplies a directory, refresh() drops the
+// trees that overlap it, since files may have been copied there since
+// they were enumerated.
+// ─────────────────────────────────────────────────────────────────────────
+class DirectoryIndex {
+public:
+    static constexpr int kMaxDepth = 4;
+
+    // The path of fileName under root, or empty if it is not there.  An
+    // empty root matches nothing.  If cancel is set while the root is
+    // enumerated, nothing is indexed and the lookup fails.
+    QString find(const QString &root, const QString &fileName,
+                 QAtomicInt *cancel);
+
+    // Forgets every indexed root that is dir, lies below it or contains it.
+    void refresh(const QString &dir);
+    void clear();
+
+    // Totals, for the debug log.
+    int    rootCount() const;
+    qint64 entryCount() const;
+
+private:
+    using Names = QHash<QString, QString>;   // key(file name) → path
+
+    mutable QMutex        m_mutex;
+    QHash<QString, Names> m_roots;           // clean absolute root → names
+};
@@ -0,0 +1,252 @@
+#include "directorywalker.h"
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#  include <sys/syscall.h>
+#  ifdef SYS_getdents64
+#    include <dirent.h>
+#    include <fcntl.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define HAVE_GETDENTS64 1
+#  endif
+#endif
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+namespace {
+
+struct Directory {
+    QString     path;
+    int         depth{0};
+    QStringList names;
+    std::vector<std::unique_ptr<Directory>> subdirs;   // in name order
+};
+
+#ifdef HAVE_GETDENTS64
+// The kernel's record layout; glibc only declares it from 2.30 on.
+struct LinuxDirent64 {
+    quint64        d_ino;
+    qint64         d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[1];
+};
+#endif
+
+} // namespace
+
+// QDir's default Name | IgnoreCase order, which the depth-first search
+// this walker replaced visited subdirectories in.
+static bool nameLess(const QString &a, const QString &b)
+{
+    const int r = a.compare(b, Qt::CaseInsensitive);
+    return r != 0 ? r < 0 : a < b;
+}
+
+static QString joinPath(const QString &dir, const QString &name)
+{
+    return dir.endsWith(QLatin1Char('/')) ? dir + name
+                                          : dir + QLatin1Char('/') + name;
+}
+
+// Appends the entries of path to names and, if wanted, the directories
+// among them that are not hidden to subdirs.  An unreadable directory
+// lists as empty.
+static void listDirectory(const QString &path, QStringList &names,
+                          QStringList *subdirs, std::vector<char> &buffer)
+{
+#ifdef HAVE_GETDENTS64
+    const int fd = ::open(QFile::encodeName(path).constData(),
+                          O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    for (;;) {
+        const long n = ::syscall(SYS_getdents64, fd, buffer.data(),
+                                 buffer.size());
+        if (n <= 0) break;
+        for (long off = 0; off < n;) {
+            const auto *e = reinterpret_cast<const LinuxDirent64 *>(
+                buffer.data() + off);
+            off += e->d_reclen;
+
+            const char *name = e->d_name;
+            if (name[0] == '.'
+                    && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))
+                continue;
+            names << QFile::decodeName(name);
+            if (!subdirs || name[0] == '.') continue;
+
+            bool isDir = e->d_type == DT_DIR;
+            if (e->d_type == DT_LNK || e->d_type == DT_UNKNOWN) {
+                struct stat st;
+                isDir = ::fstatat(fd, name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+            }
+            if (isDir) *subdirs << names.constLast();
+        }
+    }
+    ::close(fd);
+#else
+    Q_UNUSED(buffer)
+    const QDir dir(path);
+    names << dir.entryList(QDir::AllEntries | QDir::Hidden | QDir::System
+                           | QDir::NoDotAndDotDot, QDir::NoSort);
+    if (subdirs)
+        *subdirs << dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot,
+                                  QDir::NoSort);
+#endif
+}
+
+namespace {
+
+// One walk: a queue of directories waiting to be listed per thread, and a
+// count of directories queued but not yet listed.
+class Walk {
+public:
+    Walk(int maxDepth, QAtomicInt *cancel, int threads)
+        : m_maxDepth(maxDepth), m_cancel(cancel), m_queues(size_t(threads)) {}
+
+    bool cancelled() const { return m_cancel && m_cancel->loadAcquire(); }
+    bool pending() const   { return m_pending.loadAcquire() > 0; }
+
+    // Lists d and queues its subdirectories on thread self's queue.
+    void list(int self, Directory &d, std::vector<char> &buffer)
+    {
+        QStringList subdirs;
+        listDirectory(d.path, d.names,
+                      d.depth < m_maxDepth ? &subdirs : nullptr, buffer);
+        if (subdirs.isEmpty()) return;
+
+        std::sort(subdirs.begin(), subdirs.end(), nameLess);
+        for (const QString &name : std::as_const(subdirs)) {
+            auto sub   = std::make_unique<Directory>();
+            sub->path  = joinPath(d.path, name);
+            sub->depth = d.depth + 1;
+            d.subdirs.push_back(std::move(sub));
+        }
+
+        m_pending.fetchAndAddOrdered(int(d.subdirs.size()));
+        {
+            Queue &q = m_queues[size_t(self)];
+            QMutexLocker lk(&q.mutex);
+            for (const auto &sub : d.subdirs) q.dirs.push_back(sub.get());
+        }
+        wakeIdle();
+    }
+
+    // Thread loop: lists directories until none are left or the walk is
+    // cancelled.
+    void run(int self)
+    {
+        std::vector<char> buffer(
+            static_cast<size_t>(DirectoryWalker::kBufferBytes));
+        while (!cancelled()) {
+            const quint64 seen = m_generation.loadAcquire();
+            if (Directory *d = next(self)) {
+                list(self, *d, buffer);
+                if (m_pending.fetchAndSubOrdered(1) == 1) wakeIdle();
+                continue;
+            }
+            QMutexLocker lk(&m_idleMutex);
+            if (!pending()) break;
+            // Cancellation is a flag nobody signals, so wake up now and then.
+            if (m_generation.loadAcquire() == seen)
+                m_more.wait(&m_idleMutex, 100);
+        }
+    }
+
+private:
+    struct Queue {
+        QMutex                  mutex;
+        std::deque<Directory *> dirs;
+    };
+
+    // The newest directory on the own queue, else the oldest, and so
+    // shallowest, one on another thread's queue.
+    Directory *next(int self)
+    {
+        const int n = int(m_queues.size());
+        for (int k = 0; k < n; ++k) {
+            Queue &q = m_queues[size_t((self + k) % n)];
+            QMutexLocker lk(&q.mutex);
+            if (q.dirs.empty()) continue;
+            Directory *d;
+            if (k == 0) {
+                d = q.dirs.back();
+                q.dirs.pop_back();
+            } else {
+                d = q.dirs.front();
+                q.dirs.pop_front();
+            }
+            return d;
+        }
+        return nullptr;
+    }
+
+    void wakeIdle()
+    {
+        m_generation.fetchAndAddOrdered(1);
+        QMutexLocker lk(&m_idleMutex);
+        m_more.wakeAll();
+    }
+
+    const int          m_maxDepth;
+    QAtomicInt        *m_cancel;
+    std::vector<Queue> m_queues;
+    QAtomicInt         m_pending{0};
+
+    QMutex                  m_idleMutex;
+    QWaitCondition          m_more;         // work queued or walk finished
+    QAtomicInteger<quint64> m_generation{0};
+};
+
+} // namespace
+
+static void visitTree(const Directory &d, const DirectoryWalker::Visitor &visit)
+{
+    visit(d.path, d.names);
+    for (const auto &sub : d.subdirs) visitTree(*sub, visit);
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+bool DirectoryWalker::walk(const QString &root, int maxDepth,
+                           QAtomicInt *cancel, const Visitor &visit)
+{
+    Walk w(maxDepth, cancel, kThreads);
+    if (w.cancelled()) return false;
+
+    // The root is listed here; a directory without subdirectories starts
+    // no threads.
+    Directory top;
+    top.path = root;
+    {
+        std::vector<char> buffer(static_cast<size_t>(kBufferBytes));
+        w.list(0, top, buffer);
+    }
+
+    if (w.pending()) {
+        std::vector<std::unique_ptr<QThread>> threads;
+        for (int t = 1; t < kThreads; ++t)
+            threads.emplace_back(QThread::create([&w, t] { w.run(t); }));
+        for (auto &t : threads) t->start();
+        w.run(0);
+        for (auto &t : threads) t->wait();
+    }
+
+    if (w.cancelled()) return false;
+    visitTree(top, visit);
+    return true;
+}
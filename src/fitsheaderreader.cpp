@@ -0,0 +1,208 @@
+#include "fitsheaderreader.h"
+#include "framekeywordschema.h"
+#include "debuglogger.h"
+#include "pagecachehints.h"
+#include <QFile>
+#include <QFileInfo>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+// Value of a "KEYWORD = value / comment" card: string values are unquoted
+// ('' is an escaped quote), anything else is cut at the comment slash.
+static QString cardValue(const char *card)
+{
+    const QByteArray rest(card + 10, FitsHeaderReader::kCardBytes - 10);
+    const QByteArray t = rest.trimmed();
+    if (t.startsWith('\'')) {
+        QByteArray out;
+        for (int i = 1; i < t.size(); ++i) {
+            if (t.at(i) == '\'') {
+                if (i + 1 < t.size() && t.at(i + 1) == '\'') {
+                    out += '\'';
+                    ++i;
+                    continue;
+                }
+                break;
+            }
+            out += t.at(i);
+        }
+        return QString::fromLatin1(out).trimmed();
+    }
+    const int slash = t.indexOf('/');
+    return QString::fromLatin1(slash < 0 ? t : t.left(slash)).trimmed();
+}
+
+// Header records from prefetched bytes first, then from the file, which is
+// only opened once they run out.
+class RecordSource {
+public:
+    RecordSource(QFile &f, const QByteArray &prefetched)
+        : m_file(f), m_prefetched(prefetched)
+    {
+        if (m_file.isOpen()) PageCacheHints::randomAccess(m_file.handle());
+    }
+
+    // The header records are not needed again.
+    ~RecordSource()
+    {
+        if (m_file.isOpen())
+            PageCacheHints::dontNeed(m_file.handle(), 0, m_pos);
+    }
+
+    // The next n bytes without consuming them (fewer at end of file).
+    QByteArray peek(qint64 n)
+    {
+        if (m_pos + n <= m_prefetched.size())
+            return QByteArray::fromRawData(m_prefetched.constData() + m_pos, n);
+        return open() ? m_file.peek(n) : QByteArray();
+    }
+
+    QByteArray read(qint64 n)
+    {
+        if (m_pos + n <= m_prefetched.size()) {
+            const QByteArray r = QByteArray::fromRawData(
+                m_prefetched.constData() + m_pos, n);
+            m_pos += n;
+            return r;
+        }
+        if (!open()) return {};
+        const QByteArray r = m_file.read(n);
+        m_pos += r.size();
+        return r;
+    }
+
+private:
+    bool open()
+    {
+        if (m_file.isOpen()) return true;
+        if (!m_file.open(QIODevice::ReadOnly)) return false;
+        PageCacheHints::randomAccess(m_file.handle());
+        return m_file.seek(m_pos);
+    }
+
+    QFile            &m_file;
+    const QByteArray &m_prefetched;
+    qint64            m_pos{0};
+};
+
+// One header unit: its records up to and including the END card.
+struct HeaderUnit {
+    bool ended{false};
+    int  naxis{-1};
+    bool compressedImage{false};    // ZIMAGE = T (tile-compressed image)
+};
+
+// Reads the header unit at the current position into raw (earlier values
+// win).  The position is left right after the unit's last record.
+static HeaderUnit readHeaderUnit(RecordSource                  &src,
+                                 FrameKeywordSchema::RawValues &raw)
+{
+    using R = FitsHeaderReader;
+    HeaderUnit unit;
+    for (int rec = 0; rec < R::kMaxRecords && !unit.ended; ++rec) {
+        const QByteArray block = src.read(R::kRecordBytes);
+        if (block.size() < R::kRecordBytes) break;
+        for (int off = 0; off < R::kRecordBytes; off += R::kCardBytes) {
+            const char *card = block.constData() + off;
+            QByteArrayView key(card, 8);
+            while (!key.isEmpty() && key.back() == ' ') key.chop(1);
+            if (key.size() == 3 && std::memcmp(key.data(), "END", 3) == 0) {
+                unit.ended = true;
+                break;
+            }
+            if (card[8] != '=') continue;
+            if (key.size() == 5 && std::memcmp(key.data(), "NAXIS", 5) == 0) {
+                unit.naxis = cardValue(card).toInt();
+            } else if (key.size() == 6
+                       && std::memcmp(key.data(), "ZIMAGE", 6) == 0) {
+                unit.compressedImage = cardValue(card) == QLatin1String("T");
+            } else {
+                const int i = FrameKeywordSchema::indexOf(key);
+                if (i >= 0 && raw[i].isEmpty())
+                    raw[i] = cardValue(card);
+            }
+        }
+    }
+    return unit;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+bool FitsHeaderReader::hasMagic(QByteArrayView firstBytes)
+{
+    return firstBytes.startsWith("SIMPLE  =");
+}
+
+bool FitsHeaderReader::isFitsPath(const QString &path)
+{
+    return path.endsWith(QLatin1String(".fit"),  Qt::CaseInsensitive)
+        || path.endsWith(QLatin1String(".fits"), Qt::CaseInsensitive)
+        || path.endsWith(QLatin1String(".fts"),  Qt::CaseInsensitive)
+        || path.endsWith(QLatin1String(".fz"),   Qt::CaseInsensitive);
+}
+
+std::optional<XisfFrameData> FitsHeaderReader::read(const QString    &path,
+                                                    const QByteArray &prefetched)
+{
+    auto &dbg = DebugLogger::instance();
+    const bool logging = dbg.isSessionActive();
+    const QString fileName = QFileInfo(path).fileName();
+
+    QFile f(path);
+    if (prefetched.isEmpty() && !f.open(QIODevice::ReadOnly)) {
+        if (logging)
+            dbg.logWarning(QStringLiteral("FITS: cannot open '%1'").arg(fileName));
+        return std::nullopt;
+    }
+
+    RecordSource src(f, prefetched);
+    if (!hasMagic(src.peek(16))) {
+        if (logging)
+            dbg.logWarning(QStringLiteral("FITS: no SIMPLE card in '%1'")
+                               .arg(fileName));
+        return std::nullopt;
+    }
+
+    // ── Collect the schema cards, record by record, until END ────────────
+    FrameKeywordSchema::RawValues raw;
+    const HeaderUnit primary = readHeaderUnit(src, raw);
+    if (!primary.ended) {
+        if (logging)
+            dbg.logWarning(QStringLiteral("FITS: no END card in '%1'")
+                               .arg(fileName));
+        return std::nullopt;
+    }
+
+    // fpack (.fz) leaves the primary HDU empty and stores the image as a
+    // compressed binary table in the first extension, whose header carries
+    // the original keywords.  With NAXIS = 0 there is no primary data, so
+    // that header follows directly; the table itself is never read.
+    if (primary.naxis == 0 && src.peek(9) == "XTENSION=") {
+        FrameKeywordSchema::RawValues ext = raw;
+        const HeaderUnit unit = readHeaderUnit(src, ext);
+        if (unit.ended && unit.compressedImage) {
+            raw = ext;
+            if (logging)
+                dbg.logDecision(QStringLiteral(
+                    "FITS '%1': tile-compressed image HDU").arg(fileName));
+        }
+    }
+
+    // DATE-LOC, else DATE-OBS (UTC) in local time; see the schema.
+    XisfFrameData result;
+    FrameKeywordSchema::apply(raw, FrameKeywordSchema::kEntryCount, result,
+                              QStringLiteral("FITS '%1'").arg(fileName));
+    if (!result.date.isValid()) {
+        if (logging)
+            dbg.logWarning(
+                QStringLiteral("FITS '%1': DATE-LOC/DATE-OBS absent or "
+                               "unparseable — frame skipped").arg(fileName));
+        return std::nullopt;
+    }
+    return result;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "xisfheaderreader.h"
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <optional>
+
+// Reads the same acquisition keywords as XisfHeaderReader from the primary
+// header of a FITS file (.fit / .fits / .fts), as written by Siril.
+//
+// The header is a sequence of 2880-byte records of 80-character cards
+// terminated by an END card; reading stops there and never touches the
+// pixel data.  For a tile-compressed .fz file the header of the
+// compressed image extension is read as well, without decompressing
+// anything.  Cards are mapped through FrameKeywordSchema including its
+// FITS-only fallback rows (DATE-OBS, CCD-TEMP, EXPOSURE), because capture
+// programs writing FITS often omit DATE-LOC and SET-TEMP.
+class FitsHeaderReader {
+public:
+    static constexpr int kRecordBytes = 2880;
+    static constexpr int kCardBytes   = 80;
+    static constexpr int kMaxRecords  = 1000;   // ~2.8 MB of header cards
+
+    // prefetched, if not empty, holds the first bytes of the file (e.g. from
+    // BatchHeaderIo); the file is then opened only if the header is longer.
+    static std::optional<XisfFrameData> read(const QString    &path,
+                                             const QByteArray &prefetched = {});
+
+    // True if the file starts with a FITS primary header.
+    static bool hasMagic(QByteArrayView firstBytes);
+
+    // True for the file extensions Siril writes FITS frames with
+    // (including tile-compressed .fz).
+    static bool isFitsPath(const QString &path);
+};
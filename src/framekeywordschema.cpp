@@ -0,0 +1,143 @@
+#include "framekeywordschema.h"
+#include "debuglogger.h"
+#include <QDateTime>
+#include <QTimeZone>
+#include <cmath>
+
+namespace FrameKeywordSchema {
+
+int indexOf(QByteArrayView name)
+{
+    const std::string_view sv(name.data(), static_cast<size_t>(name.size()));
+    const int i = kTable[hashName(sv, kSeed) & (kTableSize - 1)];
+    if (i < 0) return -1;
+
+    const std::string_view want = kEntries[i].name;
+    if (sv.size() != want.size()) return -1;
+    for (size_t k = 0; k < sv.size(); ++k) {
+        char c = sv[k];
+        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - ('a' - 'A'));
+        if (c != want[k]) return -1;
+    }
+    return i;
+}
+
+int xisfIndexOf(QByteArrayView name)
+{
+    const int i = indexOf(name);
+    return i < kXisfEntryCount ? i : -1;
+}
+
+static QString stripQuotes(const QString &s)
+{
+    QString t = s.trimmed();
+    if (t.startsWith(u'\'')) t = t.mid(1);
+    if (t.endsWith(u'\''))   t.chop(1);
+    return t.trimmed();
+}
+
+bool apply(const RawValues &raw, int rowCount, XisfFrameData &out,
+           const QString &logLabel)
+{
+    auto &dbg = DebugLogger::instance();
+    const bool logging = dbg.isSessionActive();
+
+    // Fields already filled by an earlier row.
+    bool filled[static_cast<int>(Field::FNumber) + 1] = {};
+    bool hasDateKeyword = false;
+
+    for (int i = 0; i < rowCount; ++i) {
+        const Entry   &e    = kEntries[i];
+        const QString  name = QString::fromLatin1(e.name.data(),
+                                                  qsizetype(e.name.size()));
+        if (logging)
+            dbg.logPattern(name,
+                QStringLiteral("FITSKeyword name=\"%1\"").arg(name),
+                !raw[i].isEmpty(), raw[i].left(80));
+
+        bool &done = filled[static_cast<int>(e.field)];
+        if (done || raw[i].isEmpty()) continue;
+        if (e.field == Field::NightDate) hasDateKeyword = true;
+
+        const QString v = stripQuotes(raw[i]);
+        bool   ok  = false;
+        double num = 0;
+        QDate  night;
+        switch (e.type) {
+        case Type::Text:
+            ok = true;
+            break;
+        case Type::Integer:
+        case Type::Real:
+            num = v.toDouble(&ok);
+            break;
+        case Type::LocalDateTime:
+            night = XisfHeaderReader::observingNight(v);
+            ok    = night.isValid();
+            break;
+        case Type::UtcDateTime: {
+            QDateTime dt = QDateTime::fromString(v, Qt::ISODateWithMs);
+            if (!dt.isValid()) dt = QDateTime::fromString(v, Qt::ISODate);
+            if (dt.isValid())
+                night = QDateTime(dt.date(), dt.time(), QTimeZone::utc())
+                            .toLocalTime().addSecs(-12 * 3600).date();
+            ok = night.isValid();
+            break;
+        }
+        }
+        if (!ok) {
+            if (logging)
+                dbg.logWarning(QStringLiteral("%1: could not parse %2 '%3'")
+                                   .arg(logLabel, name, v));
+            continue;
+        }
+
+        const int rounded = static_cast<int>(std::round(num));
+        switch (e.field) {
+        case Field::NightDate:
+            out.date = night;
+            break;
+        case Field::Gain:
+            out.gain = rounded;
+            break;
+        case Field::SensorTemp:
+            out.sensorTemp    = rounded;
+            out.hasSensorTemp = true;
+            break;
+        case Field::Filter:
+            out.filter = v;
+            break;
+        case Field::Object:
+            out.object = v;
+            break;
+        case Field::AmbTemp:
+            out.ambTemp    = num;
+            out.hasAmbTemp = true;
+            break;
+        case Field::Binning:
+            if (rounded < 1) continue;
+            out.binning = rounded;
+            break;
+        case Field::Exposure:
+            out.exposureSec = num;
+            break;
+        case Field::Iso:
+            out.iso    = rounded;
+            out.hasIso = true;
+            break;
+        case Field::FNumber:
+            out.fNumber    = num;
+            out.hasFNumber = true;
+            break;
+        }
+        done = true;
+
+        if (logging)
+            dbg.logResult(QStringLiteral("%1 %2").arg(logLabel, name),
+                          e.field == Field::NightDate
+                              ? night.toString(Qt::ISODate) : v);
+    }
+    return hasDateKeyword;
+}
+
+} // namespace FrameKeywordSchema
@@ -0,0 +1,150 @@
+#pragma once
+#include "xisfheaderreader.h"
+#include <QByteArrayView>
+#include <QString>
+#include <array>
+#include <string_view>
+
+// ── FrameKeywordSchema ────────────────────────────────────────────────────
+//
+// The header keywords read from every registered frame, declared as data:
+// each row maps a keyword to the XisfFrameData field it fills and how its
+// value is parsed.  Adding a column is adding a row here.
+//
+// At build time the names are compiled into a perfect hash, so looking up a
+// keyword found in a header costs one hash and one string comparison no
+// matter how many rows the schema has.
+//
+// When several rows fill the same field the earlier row wins.  FitsOnly
+// rows are fallbacks for keywords that FITS-writing capture programs use
+// instead; they are not read from XISF frames.  They must come last.
+// ─────────────────────────────────────────────────────────────────────────
+namespace FrameKeywordSchema {
+
+enum class Field {
+    NightDate,      // observing night: date/time minus 12 h
+    Gain,
+    SensorTemp,
+    Filter,
+    Object,
+    AmbTemp,
+    Binning,
+    Exposure,
+    Iso,
+    FNumber,
+};
+
+enum class Type {
+    Text,
+    Integer,        // rounded
+    Real,
+    LocalDateTime,
+    UtcDateTime,    // converted to local time first
+};
+
+struct Entry {
+    std::string_view name;      // upper case
+    Field            field;
+    Type             type;
+    bool             fitsOnly;
+};
+
+inline constexpr Entry kEntries[] = {
+    { "DATE-LOC", Field::NightDate,  Type::LocalDateTime, false },
+    { "GAIN",     Field::Gain,       Type::Integer,       false },
+    { "SET-TEMP", Field::SensorTemp, Type::Integer,       false },
+    { "FILTER",   Field::Filter,     Type::Text,          false },
+    { "OBJECT",   Field::Object,     Type::Text,          false },
+    { "AMBTEMP",  Field::AmbTemp,    Type::Real,          false },
+    { "XBINNING", Field::Binning,    Type::Integer,       false },
+    { "EXPTIME",  Field::Exposure,   Type::Real,          false },
+    { "ISO",      Field::Iso,        Type::Integer,       false },
+    { "FOCRATIO", Field::FNumber,    Type::Real,          false },
+    { "DATE-OBS", Field::NightDate,  Type::UtcDateTime,   true  },
+    { "CCD-TEMP", Field::SensorTemp, Type::Integer,       true  },
+    { "EXPOSURE", Field::Exposure,   Type::Real,          true  },
+};
+
+inline constexpr int kEntryCount =
+    static_cast<int>(sizeof(kEntries) / sizeof(kEntries[0]));
+
+// Number of leading rows that apply to XISF frames.
+constexpr int countXisfEntries()
+{
+    int n = 0;
+    while (n < kEntryCount && !kEntries[n].fitsOnly) ++n;
+    for (int i = n; i < kEntryCount; ++i)
+        if (!kEntries[i].fitsOnly) return -1;
+    return n;
+}
+inline constexpr int kXisfEntryCount = countXisfEntries();
+static_assert(kXisfEntryCount > 0, "FitsOnly rows must come last");
+
+// ── Perfect hash ──────────────────────────────────────────────────────────
+
+// FNV-1a over the upper-cased name, so lookups are case-insensitive.
+constexpr quint32 hashName(std::string_view s, quint32 seed)
+{
+    quint32 h = 2166136261u ^ seed;
+    for (char c : s) {
+        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - ('a' - 'A'));
+        h ^= static_cast<quint8>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+inline constexpr quint32 kTableSize = 64;   // power of two
+static_assert(kTableSize >= 2 * kEntryCount, "grow kTableSize");
+
+constexpr bool seedIsPerfect(quint32 seed)
+{
+    bool used[kTableSize] = {};
+    for (const Entry &e : kEntries) {
+        const quint32 slot = hashName(e.name, seed) & (kTableSize - 1);
+        if (used[slot]) return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr quint32 findSeed()
+{
+    for (quint32 seed = 0; seed < 100000; ++seed)
+        if (seedIsPerfect(seed)) return seed;
+    return ~0u;
+}
+inline constexpr quint32 kSeed = findSeed();
+static_assert(kSeed != ~0u, "no perfect hash seed for the schema");
+
+constexpr std::array<qint8, kTableSize> buildTable()
+{
+    std::array<qint8, kTableSize> t{};
+    for (auto &slot : t) slot = -1;
+    for (int i = 0; i < kEntryCount; ++i)
+        t[hashName(kEntries[i].name, kSeed) & (kTableSize - 1)] =
+            static_cast<qint8>(i);
+    return t;
+}
+inline constexpr std::array<qint8, kTableSize> kTable = buildTable();
+
+// Row index of a keyword name (any case, no surrounding blanks), or -1.
+int indexOf(QByteArrayView name);
+
+// Same, restricted to the rows read from XISF frames.
+int xisfIndexOf(QByteArrayView name);
+
+// ── Applying values ───────────────────────────────────────────────────────
+
+// Raw header values, one per row; an empty string means "not present".
+// Surrounding single quotes are allowed.
+using RawValues = std::array<QString, kEntryCount>;
+
+// Fills out from the first rowCount rows of raw.  Returns false if none of
+// them carries a date keyword (an unparseable date leaves out.date
+// invalid).  With a debug session active each row is reported under
+// logLabel.
+bool apply(const RawValues &raw, int rowCount, XisfFrameData &out,
+           const QString &logLabel);
+
+} // namespace FrameKeywordSchema
@@ -1,11 +1,75 @@
 #include "frameresolverworker.h"
 #include "xisfheaderreader.h"
+#include "fitsheaderreader.h"
 #include "xisfmasterframereader.h"
+#include "headermetadatacache.h"
+#include "batchheaderio.h"
+#include "pagecachehints.h"
+#include "pathrewriterules.h"
 #include "debuglogger.h"
+#include <QElapsedTimer>
 #include <QFile>
 #include <QDir>
 #include <QMutexLocker>
 
+// Registered frames are usually .xisf for WBPP logs and FITS for Siril
+// logs, but WBPP can be fed FITS too.  The extension picks the reader
+// tried first, so the common case costs one open; if that reader rejects
+// the file, its magic bytes decide whether the other one is tried.
+// prefetched holds the first bytes of the file if they were read ahead.
+static std::optional<XisfFrameData> readFrameHeaderUncached(
+    const QString &path, const QByteArray &prefetched)
+{
+    const bool fitsName = FitsHeaderReader::isFitsPath(path);
+    auto result = fitsName ? FitsHeaderReader::read(path, prefetched)
+                           : XisfHeaderReader::read(path, prefetched);
+    if (result) return result;
+
+    QByteArray magic = prefetched.left(16);
+    if (magic.isEmpty()) {
+        QFile f(path);
+        if (!f.open(QIODevice::ReadOnly)) return std::nullopt;
+        magic = f.read(16);
+    }
+    if (!fitsName && FitsHeaderReader::hasMagic(magic))
+        return FitsHeaderReader::read(path, prefetched);
+    if (fitsName && magic.startsWith("XISF0100"))
+        return XisfHeaderReader::read(path, prefetched);
+    return std::nullopt;
+}
+
+// Headers of unchanged files come from HeaderMetadataCache.  stamp, if
+// given, was taken when the frame was prefetched.
+static std::optional<XisfFrameData> readFrameHeader(
+    const QString                     &path,
+    const HeaderMetadataCache::Stamp  *stamp      = nullptr,
+    const QByteArray                  &prefetched = {})
+{
+    std::optional<HeaderMetadataCache::Stamp> st;
+    if (stamp) st = *stamp;
+    else       st = HeaderMetadataCache::stamp(path);
+    if (!st) return readFrameHeaderUncached(path, {});   // logs the failure
+    if (auto cached = HeaderMetadataCache::frame(path, *st))
+        return cached;
+
+    auto result = readFrameHeaderUncached(path, prefetched);
+    if (result) HeaderMetadataCache::storeFrame(path, *st, *result);
+    return result;
+}
+
+// Same for master frame counts.
+static std::optional<int> readMasterCount(const QString &path)
+{
+    const auto stamp = HeaderMetadataCache::stamp(path);
+    if (!stamp) return std::nullopt;
+    if (auto cached = HeaderMetadataCache::masterCount(path, *stamp))
+        return cached;
+
+    auto count = XisfMasterFrameReader::readFrameCount(path);
+    if (count) HeaderMetadataCache::storeMasterCount(path, *stamp, *count);
+    return count;
+}
+
 // ── Public API ────────────────────────────────────────────────────────────
 
 void FrameResolveWorker::supplyDirectory(const QString &dir)
@@ -32,15 +96,53 @@ void FrameResolveWorker::run()
                       QString::number(total));
     }
 
+    // Prefix rewrites recorded in earlier imports of the loaded logs, so
+    // relocated frames are read where they are now without searching.  A
+    // frame missing at its own path is tried at its rewritten path.
+    masterCache->rewrites.clear();
+    for (auto it = logToMasterDir.constBegin();
+         it != logToMasterDir.constEnd(); ++it)
+        for (const auto &rule : PathRewriteRules::forLog(it.key()))
+            if (!masterCache->rewrites.contains(rule))
+                masterCache->rewrites << rule;
+    {
+        QMutexLocker lk(&m_rewritesMutex);
+        m_rewrites = masterCache->rewrites;
+    }
+    if (dbg.isSessionActive() && !masterCache->rewrites.isEmpty())
+        dbg.logResult(QStringLiteral("recordedRewrites"),
+                      QString::number(masterCache->rewrites.size()));
+
+    // Locate and I/O stages run ahead; parse/apply stays on this thread.
+    QStringList paths;
+    paths.reserve(total);
+    for (const auto &grp : std::as_const(*groups))
+        for (const auto &frame : grp.frames)
+            paths << frame.registeredPath;
+    QElapsedTimer timer;
+    timer.start();
+    HeaderPipeline pipeline(paths, ioConcurrency, cancelFlag,
+                            [this](const QString &path) {
+                                QMutexLocker lk(&m_rewritesMutex);
+                                return PathRewriteRules::rewrite(m_rewrites,
+                                                                 path);
+                            });
+
+    qsizetype index = 0;
     for (auto &grp : *groups) {
         for (auto &frame : grp.frames) {
+            const qsizetype i = index++;
             if (cancelFlag->loadAcquire()) {
                 emit progress(++done, total);
                 continue;
             }
 
-            // Stage 1: resolve XISF header.
-            if (resolveHeader(frame, grp.sourceLogFile)) {
+            const std::optional<HeaderPipeline::Item> located =
+                pipeline.take(i);
+
+            // Stage 1: resolve XISF / FITS header.
+            if (resolveHeader(frame, grp.sourceLogFile,
+                              located ? &*located : nullptr)) {
                 // Apply target: log keyword takes priority over OBJECT header.
                 if (!frame.targetFromLog && !frame.object.isEmpty())
                     frame.logTarget = frame.object;
@@ -58,6 +160,25 @@ void FrameResolveWorker::run()
         }
     }
 
+    if (dbg.isSessionActive()) {
+        const double ms   = qMax<qint64>(1, timer.elapsed());
+        const qint64 read = pipeline.bytesRead();
+        dbg.logResult(QStringLiteral("headerIo"),
+            QStringLiteral("%1 files, %2 KB in %3 ms (%4 MB/s, "
+                           "%5 I/O threads, %6, page cache hints %7)")
+                .arg(pipeline.filesRead()).arg(read / 1024).arg(ms, 0, 'f', 0)
+                .arg(read / 1048.576 / ms, 0, 'f', 1)
+                .arg(ioConcurrency)
+                .arg(BatchHeaderIo::usesIoUring() ? QStringLiteral("io_uring")
+                                                  : QStringLiteral("QFile"))
+                .arg(!PageCacheHints::enabled()      ? QStringLiteral("off")
+                     : PageCacheHints::dropAfterRead() ? QStringLiteral("on, drop")
+                                                       : QStringLiteral("on")));
+        dbg.logResult(QStringLiteral("dirIndex"),
+            QStringLiteral("%1 roots, %2 names")
+                .arg(dirIndex->rootCount()).arg(dirIndex->entryCount()));
+    }
+
     if (dbg.isSessionActive()) {
         int resolved = 0;
         for (const auto &grp : *groups)
@@ -69,70 +190,108 @@ void FrameResolveWorker::run()
                       QString::number(total - resolved));
     }
 
+    HeaderMetadataCache::save();
+    PathRewriteRules::save();
     emit finished();
 }
 
 // ── Header resolution ─────────────────────────────────────────────────────
 
-bool FrameResolveWorker::resolveHeader(AcquisitionFrame &frame,
-                                        const QString    &sourceLogFile)
+bool FrameResolveWorker::resolveHeader(AcquisitionFrame           &frame,
+                                        const QString              &sourceLogFile,
+                                        const HeaderPipeline::Item *located)
 {
-    QString path = frame.registeredPath;
-    auto result  = XisfHeaderReader::read(path);
+    const QString originalPath = frame.registeredPath;
+    QString       path         = originalPath;
+    std::optional<XisfFrameData> result;
+    if (!located) {
+        result = readFrameHeader(path);
+    } else if (located->stamp) {
+        // Possibly at the path a rewrite rule gave it.
+        path   = located->path;
+        frame.registeredPath = path;
+        result = readFrameHeader(path, &*located->stamp, located->bytes);
+    } else {
+        result = readFrameHeaderUncached(path, {});   // logs the failure
+    }
 
-    // ── Primary cache ─────────────────────────────────────────────────────
+    // ── Learned prefix rewrites ───────────────────────────────────────────
+    // Rules learned after the pipeline located this frame.
     if (!result && !QFile::exists(path)) {
+        const QString candidate =
+            PathRewriteRules::rewrite(masterCache->rewrites, path);
+        if (!candidate.isEmpty() && QFile::exists(candidate)) {
+            path = candidate;
+            frame.registeredPath = path;
+            result = readFrameHeader(path);
+        }
+    }
+
+    // A file no automatic tier found for an earlier frame of this log is
+    // not searched for again until the searched directories change.
+    const QString missKey =
+        QFileInfo(path).fileName() + QLatin1Char('\n') + sourceLogFile;
+    const bool knownMissing = !result && m_regMissing.contains(missKey);
+
+    // ── Primary cache ─────────────────────────────────────────────────────
+    if (!result && !knownMissing && !QFile::exists(path)) {
         const QString fn = QFileInfo(path).fileName();
         for (const QString &dir : std::as_const(m_regPrimaryCache)) {
             QString candidate = QDir(dir).filePath(fn);
             if (QFile::exists(candidate)) {
                 path = candidate;
                 frame.registeredPath = path;
-                result = XisfHeaderReader::read(path);
+                result = readFrameHeader(path);
                 break;
             }
         }
     }
 
     // ── Secondary cache (recursive) ───────────────────────────────────────
-    if (!result && !QFile::exists(path)) {
+    if (!result && !knownMissing && !QFile::exists(path)) {
         const QString fn = QFileInfo(path).fileName();
         for (const QString &dir : std::as_const(m_regSecondaryCache)) {
             if (cancelFlag->loadAcquire()) break;
-            QString found = findRecursive(dir, fn, cancelFlag);
+            QString found = dirIndex->find(dir, fn, cancelFlag);
             if (!found.isEmpty()) {
                 QString foundDir = QFileInfo(found).absolutePath();
                 m_regPrimaryCache.insert(foundDir);
                 path = found;
                 frame.registeredPath = path;
-                result = XisfHeaderReader::read(path);
+                result = readFrameHeader(path);
                 break;
             }
         }
     }
 
     // ── Auto-probe: ../registered/ sibling of the log file ────────────────
-    if (!result && !QFile::exists(path) && !cancelFlag->loadAcquire()) {
+    if (!result && !knownMissing && !QFile::exists(path)
+            && !cancelFlag->loadAcquire()) {
         const QString fn = QFileInfo(path).fileName();
         QDir logDir = QFileInfo(sourceLogFile).absoluteDir();
         QDir parent = logDir;
         if (parent.cdUp()) {
             QDir regDir(parent.filePath(QStringLiteral("registered")));
             if (regDir.exists()) {
-                QString found = findRecursive(regDir.absolutePath(),
-                                              fn, cancelFlag);
+                QString found = dirIndex->find(regDir.absolutePath(),
+                                               fn, cancelFlag);
                 if (!found.isEmpty()) {
                     QString foundDir = QFileInfo(found).absolutePath();
                     m_regPrimaryCache.insert(foundDir);
                     m_regSecondaryCache.append(foundDir);
+                    m_regMissing.clear();
                     path = found;
                     frame.registeredPath = path;
-                    result = XisfHeaderReader::read(path);
+                    result = readFrameHeader(path);
                 }
             }
         }
     }
 
+    if (!result && !knownMissing && !QFile::exists(path)
+            && !cancelFlag->loadAcquire())
+        m_regMissing.insert(missKey);
+
     // ── User prompt ───────────────────────────────────────────────────────
     if (!result && !QFile::exists(path) && !cancelFlag->loadAcquire()
             && !m_regSkipPrompts) {
@@ -146,14 +305,16 @@ bool FrameResolveWorker::resolveHeader(AcquisitionFrame &frame,
             m_regSkipPrompts = true;
         } else {
             m_regSecondaryCache.append(suppliedDir);
+            m_regMissing.clear();
             const QString fn2  = QFileInfo(path).fileName();
-            QString       found = findRecursive(suppliedDir, fn2, cancelFlag);
+            QString       found = dirIndex->find(suppliedDir, fn2,
+                                                 cancelFlag);
             if (!found.isEmpty()) {
                 QString foundDir = QFileInfo(found).absolutePath();
                 m_regPrimaryCache.insert(foundDir);
                 path = found;
                 frame.registeredPath = path;
-                result = XisfHeaderReader::read(path);
+                result = readFrameHeader(path);
             }
         }
     }
@@ -168,12 +329,31 @@ bool FrameResolveWorker::resolveHeader(AcquisitionFrame &frame,
     frame.ambTemp       = result->ambTemp;
     frame.hasAmbTemp    = result->hasAmbTemp;
     frame.binning       = result->binning;
+    frame.iso           = result->iso;
+    frame.hasIso        = result->hasIso;
+    frame.fNumber       = result->fNumber;
+    frame.hasFNumber    = result->hasFNumber;
+
+    // Siril logs carry no exposure; take it from the FITS header.
+    if (frame.exposureSec <= 0 && result->exposureSec > 0)
+        frame.exposureSec = result->exposureSec;
 
     // FILTER from XISF header overrides log-derived filter if present.
     if (!result->filter.isEmpty())
         frame.filter = result->filter;
 
     frame.object = result->object;
+
+    // The rule that led to the frame, or the one implied by the path a
+    // search found it at, tells where the rest went.
+    if (path != originalPath) {
+        PathRewriteRules::Rule used;
+        if (PathRewriteRules::rewrite(masterCache->rewrites, originalPath,
+                                      &used) == path)
+            adoptRewrite(used, sourceLogFile);
+        else if (const auto rule = PathRewriteRules::infer(originalPath, path))
+            adoptRewrite(*rule, sourceLogFile);
+    }
     return true;
 }
 
@@ -198,7 +378,8 @@ void FrameResolveWorker::resolveCalibration(AcquisitionFrame &frame,
     if (it == basenameToBlock.end()) {
         // Try searching the calibrated directory.
         const QString calibRoot = logToCalibratedDir.value(sourceLogFile);
-        const QString found     = findRecursive(calibRoot, calBase, cancelFlag);
+        const QString found     = dirIndex->find(calibRoot, calBase,
+                                                 cancelFlag);
         if (!found.isEmpty()) {
             const QString foundBase = QFileInfo(found).fileName().toLower();
             it = basenameToBlock.find(foundBase);
@@ -251,53 +432,12 @@ int FrameResolveWorker::masterFrameCount(const QString &path,
     const QString fileName   = QFileInfo(path).fileName();
     const QString masterRoot = logToMasterDir.value(sourceLogFile);
 
-    auto tryRead = [](const QString &p) -> std::optional<int> {
-        if (p.isEmpty() || !QFile::exists(p)) return std::nullopt;
-        return XisfMasterFrameReader::readFrameCount(p);
-    };
-
-    // Tier 1: original path.
-    if (auto v = tryRead(path)) {
-        m_masterCountCache.insert(path, v.value_or(-1));
-        return v.value_or(-1);
-    }
-
-    // Tier 2: ../master/ sibling of the log file.
-    {
-        const QString found = findRecursive(masterRoot, fileName, cancelFlag);
-        if (!found.isEmpty()) {
-            const int val =
-                XisfMasterFrameReader::readFrameCount(found).value_or(-1);
-            masterCache->primaryDirs.insert(
-                QFileInfo(found).absolutePath());
-            m_masterCountCache.insert(found, val);
-            m_masterCountCache.insert(path, val);
-            return val;
-        }
-    }
-
-    // Tier 3: primary cache.
-    for (const QString &dir : std::as_const(masterCache->primaryDirs)) {
-        const QString candidate = QDir(dir).filePath(fileName);
-        if (auto v = tryRead(candidate)) {
-            m_masterCountCache.insert(path, v.value_or(-1));
-            return v.value_or(-1);
-        }
-    }
-
-    // Tier 4: secondary cache (recursive).
-    for (const QString &dir : std::as_const(masterCache->secondaryDirs)) {
-        const QString found = findRecursive(dir, fileName, cancelFlag);
-        if (!found.isEmpty()) {
-            const int val =
-                XisfMasterFrameReader::readFrameCount(found).value_or(-1);
-            const QString foundDir = QFileInfo(found).absolutePath();
-            masterCache->primaryDirs.insert(foundDir);
-            m_masterCountCache.insert(found, val);
-            m_masterCountCache.insert(path, val);
-            return val;
-        }
-    }
+    PathRewriteRules::Rule used;
+    const auto v = locateMasterFrameCount(path, masterRoot, *masterCache,
+                                          *dirIndex, m_masterCountCache,
+                                          cancelFlag, &used);
+    if (!used.from.isEmpty()) adoptRewrite(used, sourceLogFile);
+    if (v) return *v;
 
     // Tier 5: user prompt.
     if (!masterCache->skipPrompts && !cancelFlag->loadAcquire()) {
@@ -317,14 +457,17 @@ int FrameResolveWorker::masterFrameCount(const QString &path,
         }
 
         masterCache->secondaryDirs.append(suppliedDir);
-        const QString found = findRecursive(suppliedDir, fileName, cancelFlag);
+        masterCache->missing.clear();
+        const QString found = dirIndex->find(suppliedDir, fileName,
+                                             cancelFlag);
         if (!found.isEmpty()) {
-            const int val =
-                XisfMasterFrameReader::readFrameCount(found).value_or(-1);
+            const int val = readMasterCount(found).value_or(-1);
             const QString foundDir = QFileInfo(found).absolutePath();
             masterCache->primaryDirs.insert(foundDir);
             m_masterCountCache.insert(found, val);
             m_masterCountCache.insert(path, val);
+            if (const auto rule = PathRewriteRules::infer(path, found))
+                adoptRewrite(*rule, sourceLogFile);
             return val;
         }
     }
@@ -335,25 +478,81 @@ int FrameResolveWorker::masterFrameCount(const QString &path,
 
 // ── Static helpers ────────────────────────────────────────────────────────
 
-QString FrameResolveWorker::findRecursive(const QString &root,
-                                           const QString &fileName,
-                                           QAtomicInt    *cancel,
-                                           int            depth)
+std::optional<int> FrameResolveWorker::locateMasterFrameCount(
+    const QString          &path,
+    const QString          &masterRoot,
+    MasterFileCache        &cache,
+    DirectoryIndex         &index,
+    QHash<QString, int>    &counts,
+    QAtomicInt             *cancel,
+    PathRewriteRules::Rule *usedRule)
 {
-    if (depth > kMaxDepth) return {};
-    if (cancel && cancel->loadAcquire()) return {};
-
-    QDir dir(root);
-    if (dir.exists(fileName))
-        return dir.filePath(fileName);
-
-    const auto subdirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-    for (const QString &sub : subdirs) {
-        QString hit = findRecursive(dir.filePath(sub), fileName,
-                                    cancel, depth + 1);
-        if (!hit.isEmpty()) return hit;
+    const QString fileName = QFileInfo(path).fileName();
+    const QString missKey  = path + QLatin1Char('\n') + masterRoot;
+    if (cache.missing.contains(missKey)) return std::nullopt;
+
+    auto tryRead = [](const QString &p) -> std::optional<int> {
+        if (p.isEmpty()) return std::nullopt;
+        return readMasterCount(p);
+    };
+
+    // A file found by searching is read even if it yields no count, so the
+    // search is not repeated for the next frame.
+    auto foundAt = [&](const QString &found) {
+        const int val = readMasterCount(found).value_or(-1);
+        const QString foundDir = QFileInfo(found).absolutePath();
+        if (!cache.primaryDirs.contains(foundDir)) {
+            cache.primaryDirs.insert(foundDir);
+            cache.missing.clear();   // tier 3 searches more directories now
+        }
+        if (const auto rule = PathRewriteRules::infer(path, found)) {
+            if (!cache.rewrites.contains(*rule))
+                cache.rewrites.prepend(*rule);
+            if (usedRule) *usedRule = *rule;
+        }
+        counts.insert(found, val);
+        counts.insert(path, val);
+        return val;
+    };
+
+    // Tier 1: original path.
+    if (auto v = tryRead(path)) {
+        counts.insert(path, *v);
+        return v;
     }
-    return {};
+
+    // Tier 1b: original path under a learned prefix rewrite.
+    PathRewriteRules::Rule rule;
+    if (auto v = tryRead(PathRewriteRules::rewrite(cache.rewrites, path,
+                                                   &rule))) {
+        counts.insert(path, *v);
+        if (usedRule) *usedRule = rule;
+        return v;
+    }
+
+    // Tier 2: ../master/ sibling of the log file.
+    {
+        const QString found = index.find(masterRoot, fileName, cancel);
+        if (!found.isEmpty()) return foundAt(found);
+    }
+
+    // Tier 3: primary cache.
+    for (const QString &dir : std::as_const(cache.primaryDirs)) {
+        const QString candidate = QDir(dir).filePath(fileName);
+        if (auto v = tryRead(candidate)) {
+            counts.insert(path, *v);
+            return v;
+        }
+    }
+
+    // Tier 4: secondary cache (recursive).
+    for (const QString &dir : std::as_const(cache.secondaryDirs)) {
+        const QString found = index.find(dir, fileName, cancel);
+        if (!found.isEmpty()) return foundAt(found);
+    }
+
+    if (!cancel || !cancel->loadAcquire()) cache.missing.insert(missKey);
+    return std::nullopt;
 }
 
 QString FrameResolveWorker::calibratedBasenameStatic(
@@ -375,23 +574,21 @@ QString FrameResolveWorker::calibratedBasename(const QString &registeredPath)
     return calibratedBasenameStatic(registeredPath);
 }
 
-void FrameResolveWorker::remapGroup(IntegrationGroup  &grp,
-                                     const QString     &knownDir)
+void FrameResolveWorker::adoptRewrite(const PathRewriteRules::Rule &rule,
+                                      const QString                &sourceLogFile)
 {
-    for (auto &frame : grp.frames) {
-        const QString fn        = QFileInfo(frame.registeredPath).fileName();
-        const QString candidate = QDir(knownDir).filePath(fn);
-        if (QFile::exists(candidate)) {
-            frame.registeredPath = candidate;
-            continue;
-        }
-        // Search primary cache.
-        for (const QString &d : std::as_const(m_regPrimaryCache)) {
-            const QString c = QDir(d).filePath(fn);
-            if (QFile::exists(c)) {
-                frame.registeredPath = c;
-                break;
-            }
-        }
+    if (!masterCache->rewrites.contains(rule))
+        masterCache->rewrites.prepend(rule);
+    {
+        QMutexLocker lk(&m_rewritesMutex);
+        m_rewrites = masterCache->rewrites;
     }
+    if (!PathRewriteRules::record(sourceLogFile, rule)) return;
+
+    auto &dbg = DebugLogger::instance();
+    if (dbg.isSessionActive())
+        dbg.logDecision(
+            QStringLiteral("Path rewrite '%1' → '%2' located a file of '%3'; "
+                           "recorded for that log")
+                .arg(rule.from, rule.to, sourceLogFile));
 }
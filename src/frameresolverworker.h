@@ -7,16 +7,22 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QSet>
+#include <optional>
 #include "models/integrationgroup.h"
 #include "logparser/calibrationlogparser.h"
 #include "masterfilecache.h"
+#include "directoryindex.h"
+#include "headerpipeline.h"
 
 // ── FrameResolveWorker ────────────────────────────────────────────────────
 //
-// Runs on a background thread. For each AcquisitionFrame in each
-// IntegrationGroup:
-//   1. Reads the XISF header (DATE-LOC, GAIN, SET-TEMP, FILTER, OBJECT,
-//      AMBTEMP, XBINNING).
+// Runs on a background thread, with HeaderPipeline stating and reading
+// frame headers ahead of it. For each AcquisitionFrame in each
+// IntegrationGroup, in order:
+//   1. Reads the frame header — XISF, or FITS / .fz through
+//      FitsHeaderReader — with the keywords of FrameKeywordSchema
+//      (DATE-LOC, GAIN, SET-TEMP, FILTER, OBJECT, AMBTEMP, XBINNING,
+//      EXPTIME, ISO, FOCRATIO, plus the FITS-only fallbacks).
 //   2. Resolves the calibration chain: registered path → calibrated basename
 //      → Light calibration block → master dark/flat paths → frame counts.
 //      Master flat → flat integration block → master bias path → bias count.
@@ -28,12 +34,15 @@
 class FrameResolveWorker : public QObject {
     Q_OBJECT
 public:
-    static constexpr int kMaxDepth = 4;
-
     // Set by MainWindow before starting the thread.
     QList<IntegrationGroup>        *groups{nullptr};
     QAtomicInt                     *cancelFlag{nullptr};
     MasterFileCache                *masterCache{nullptr};
+    DirectoryIndex                 *dirIndex{nullptr};
+
+    // Threads in each of HeaderPipeline's locate and I/O stages
+    // (AppSettings::headerIoThreads).
+    int                             ioConcurrency{4};
 
     // Calibration lookup structures built by MainWindow from all loaded logs
     // before the worker starts.  Read-only from the worker's perspective.
@@ -57,19 +66,34 @@ signals:
                                 const QString &startDir);
     void finished();
 
-public slots:
-    void run();
-
-    static QString findRecursive(const QString &root,
-                                 const QString &fileName,
-                                 QAtomicInt    *cancel,
-                                 int            depth = 0);
-
+public:
     // Exposed as public static so MainWindow can use it for back-filling
     // calibration data on already-loaded frames after a supplementary log
     // is added.
     static QString calibratedBasenameStatic(const QString &registeredPath);
 
+    // Tiers 1–4 of the master file search, shared with MainWindow's
+    // back-fill: original path, ../master sibling of the log, primary
+    // cache, secondary cache (recursive, through index).  The count of a
+    // file found by any tier is recorded in counts for both paths and its
+    // directory is added to cache.primaryDirs.  nullopt if no tier found the
+    // file; the miss is remembered in cache.missing.  Before searching,
+    // the path is tried under cache.rewrites; a file found by searching
+    // adds the rule its new path implies to the front of cache.rewrites.
+    // If a rewrite or a search located the file, its rule is stored in
+    // usedRule, if given.
+    static std::optional<int> locateMasterFrameCount(
+        const QString          &path,
+        const QString          &masterRoot,
+        MasterFileCache        &cache,
+        DirectoryIndex         &index,
+        QHash<QString, int>    &counts,
+        QAtomicInt             *cancel,
+        PathRewriteRules::Rule *usedRule = nullptr);
+
+public slots:
+    void run();
+
 private:
     QMutex         m_mutex;
     QWaitCondition m_cond;
@@ -82,10 +106,20 @@ private:
     QList<QString> m_regSecondaryCache; // user-supplied dirs (recursive search)
     bool           m_regSkipPrompts{false};
 
+    // "file name\nlog path" of registered frames no automatic tier found.
+    // Cleared whenever a directory joins m_regSecondaryCache.
+    QSet<QString>  m_regMissing;
+
+    // Copy of masterCache->rewrites for HeaderPipeline's locate threads.
+    QMutex                        m_rewritesMutex;
+    QList<PathRewriteRules::Rule> m_rewrites;
+
     // Resolve the XISF header for a single frame, searching for the file
-    // if it is not at its original path.
-    bool resolveHeader(AcquisitionFrame &frame,
-                       const QString    &sourceLogFile);
+    // if it is not at its original path.  located is the frame's item from
+    // HeaderPipeline, if it was located at the frame's current path.
+    bool resolveHeader(AcquisitionFrame           &frame,
+                       const QString              &sourceLogFile,
+                       const HeaderPipeline::Item *located);
 
     // Resolve the calibration chain for a single frame.
     void resolveCalibration(AcquisitionFrame &frame,
@@ -95,9 +129,10 @@ private:
     int masterFrameCount(const QString &path,
                          const QString &sourceLogFile);
 
-    // Remap all registered paths in a group to a newly discovered directory.
-    void remapGroup(IntegrationGroup    &grp,
-                    const QString       &knownDir);
+    // rule just located a frame or master of sourceLogFile: it is tried for
+    // every later missing path and recorded for that log.
+    void adoptRewrite(const PathRewriteRules::Rule &rule,
+                      const QString                &sourceLogFile);
 
     // Derive the calibrated (_c.xisf) basename from a registered path.
     static QString calibratedBasename(const QString &registeredPath);
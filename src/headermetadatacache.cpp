@@ -0,0 +1,260 @@
+#include "headermetadatacache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+static constexpr quint32 kMagic   = 0x41424843;   // "ABHC"
+// Bump whenever the readers change what they extract (FrameKeywordSchema,
+// XisfHeaderReader, FitsHeaderReader, MasterCountScanner).
+static constexpr quint32 kVersion = 1;
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+using Stamp = HeaderMetadataCache::Stamp;
+
+static bool operator==(const Stamp &a, const Stamp &b)
+{
+    return a.size == b.size && a.mtimeNs == b.mtimeNs
+        && a.inode == b.inode && a.device == b.device;
+}
+
+static QDataStream &operator<<(QDataStream &out, const Stamp &s)
+{
+    return out << s.size << s.mtimeNs << s.inode << s.device;
+}
+
+static QDataStream &operator>>(QDataStream &in, Stamp &s)
+{
+    return in >> s.size >> s.mtimeNs >> s.inode >> s.device;
+}
+
+static QDataStream &operator<<(QDataStream &out, const XisfFrameData &d)
+{
+    return out << d.date << qint32(d.gain) << qint32(d.sensorTemp)
+               << d.hasSensorTemp << d.ambTemp << d.hasAmbTemp
+               << qint32(d.binning) << d.filter << d.object << d.exposureSec
+               << qint32(d.iso) << d.hasIso << d.fNumber << d.hasFNumber;
+}
+
+static QDataStream &operator>>(QDataStream &in, XisfFrameData &d)
+{
+    qint32 gain = 0, sensorTemp = 0, binning = 0, iso = 0;
+    in >> d.date >> gain >> sensorTemp >> d.hasSensorTemp >> d.ambTemp
+       >> d.hasAmbTemp >> binning >> d.filter >> d.object >> d.exposureSec
+       >> iso >> d.hasIso >> d.fNumber >> d.hasFNumber;
+    d.gain       = gain;
+    d.sensorTemp = sensorTemp;
+    d.binning    = binning;
+    d.iso        = iso;
+    return in;
+}
+
+template <typename T>
+struct CacheEntry {
+    Stamp stamp;
+    T     value{};
+    bool  used{false};      // looked up or stored this session
+};
+
+struct CacheState {
+    QMutex                                      mutex;
+    bool                                        loaded{false};
+    bool                                        dirty{false};
+    QHash<QString, CacheEntry<XisfFrameData>>   frames;
+    QHash<QString, CacheEntry<qint32>>          counts;
+    QHash<QString, QString>                     canonicalDirs;
+};
+
+static CacheState &state()
+{
+    static CacheState s;
+    return s;
+}
+
+template <typename T>
+static void writeEntries(QDataStream                        &out,
+                         const QHash<QString, CacheEntry<T>> &entries)
+{
+    // Over the limit, entries not touched this session are dropped.
+    const bool prune = entries.size() > HeaderMetadataCache::kMaxEntries;
+    qint32 n = 0;
+    for (const auto &e : entries)
+        if (!prune || e.used) ++n;
+    out << n;
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it)
+        if (!prune || it->used)
+            out << it.key() << it->stamp << it->value;
+}
+
+template <typename T>
+static bool readEntries(QDataStream &in, QHash<QString, CacheEntry<T>> &entries)
+{
+    qint32 n = 0;
+    in >> n;
+    if (n < 0) return false;
+    entries.reserve(n);
+    for (qint32 i = 0; i < n && in.status() == QDataStream::Ok; ++i) {
+        QString       key;
+        CacheEntry<T> e;
+        in >> key >> e.stamp >> e.value;
+        entries.insert(key, e);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+// Called with the mutex held.
+static void ensureLoaded(CacheState &s)
+{
+    if (s.loaded) return;
+    s.loaded = true;
+
+    QFile f(HeaderMetadataCache::cacheFilePath());
+    if (!f.open(QIODevice::ReadOnly)) return;
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != kMagic || version != kVersion
+            || !readEntries(in, s.frames) || !readEntries(in, s.counts)) {
+        s.frames.clear();
+        s.counts.clear();
+    }
+}
+
+// Canonical form of path.  Only the directory is canonicalized, once per
+// directory, so the per-file cost stays at one stat.  Called with the mutex
+// held.
+static QString canonicalKey(CacheState &s, const QString &path)
+{
+    const QFileInfo fi(path);
+    const QString   dir = fi.absolutePath();
+    auto it = s.canonicalDirs.constFind(dir);
+    if (it == s.canonicalDirs.constEnd()) {
+        QString canonical = QFileInfo(dir).canonicalFilePath();
+        if (canonical.isEmpty()) canonical = dir;
+        it = s.canonicalDirs.insert(dir, canonical);
+    }
+    return it.value() + QLatin1Char('/') + fi.fileName();
+}
+
+template <typename T>
+static std::optional<T> lookup(QHash<QString, CacheEntry<T>> CacheState::*table,
+                               const QString &path, const Stamp &stamp)
+{
+    CacheState &s = state();
+    QMutexLocker lk(&s.mutex);
+    ensureLoaded(s);
+    auto &entries = s.*table;
+    auto  it      = entries.find(canonicalKey(s, path));
+    if (it == entries.end() || !(it->stamp == stamp)) return std::nullopt;
+    it->used = true;
+    return it->value;
+}
+
+template <typename T>
+static void store(QHash<QString, CacheEntry<T>> CacheState::*table,
+                  const QString &path, const Stamp &stamp, const T &value)
+{
+    CacheState &s = state();
+    QMutexLocker lk(&s.mutex);
+    ensureLoaded(s);
+    (s.*table).insert(canonicalKey(s, path), CacheEntry<T>{ stamp, value, true });
+    s.dirty = true;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+QString HeaderMetadataCache::cacheFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+           + QStringLiteral("/headercache.bin");
+}
+
+std::optional<HeaderMetadataCache::Stamp> HeaderMetadataCache::stamp(
+    const QString &path)
+{
+    if (path.isEmpty()) return std::nullopt;
+    Stamp st;
+#ifdef Q_OS_UNIX
+    struct stat sb;
+    if (::stat(QFile::encodeName(path).constData(), &sb) != 0)
+        return std::nullopt;
+    st.size  = sb.st_size;
+#  ifdef Q_OS_DARWIN
+    st.mtimeNs = qint64(sb.st_mtimespec.tv_sec) * 1000000000
+               + sb.st_mtimespec.tv_nsec;
+#  else
+    st.mtimeNs = qint64(sb.st_mtim.tv_sec) * 1000000000 + sb.st_mtim.tv_nsec;
+#  endif
+    st.inode  = sb.st_ino;
+    st.device = sb.st_dev;
+#else
+    const QFileInfo fi(path);
+    if (!fi.exists()) return std::nullopt;
+    st.size    = fi.size();
+    st.mtimeNs = fi.lastModified().toMSecsSinceEpoch() * 1000000;
+#endif
+    return st;
+}
+
+std::optional<XisfFrameData> HeaderMetadataCache::frame(const QString &path,
+                                                        const Stamp   &stamp)
+{
+    return lookup(&CacheState::frames, path, stamp);
+}
+
+void HeaderMetadataCache::storeFrame(const QString       &path,
+                                     const Stamp         &stamp,
+                                     const XisfFrameData &data)
+{
+    store(&CacheState::frames, path, stamp, data);
+}
+
+std::optional<int> HeaderMetadataCache::masterCount(const QString &path,
+                                                    const Stamp   &stamp)
+{
+    return lookup(&CacheState::counts, path, stamp);
+}
+
+void HeaderMetadataCache::storeMasterCount(const QString &path,
+                                           const Stamp   &stamp,
+                                           int            count)
+{
+    store(&CacheState::counts, path, stamp, qint32(count));
+}
+
+void HeaderMetadataCache::save()
+{
+    CacheState &s = state();
+    QMutexLocker lk(&s.mutex);
+    if (!s.dirty) return;
+
+    const QString file = cacheFilePath();
+    if (!QDir().mkpath(QFileInfo(file).absolutePath())) return;
+
+    QSaveFile f(file);
+    if (!f.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kMagic << kVersion;
+    writeEntries(out, s.frames);
+    writeEntries(out, s.counts);
+    if (out.status() == QDataStream::Ok && f.commit())
+        s.dirty = false;
+}
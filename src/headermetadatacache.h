@@ -0,0 +1,52 @@
+#pragma once
+#include "xisfheaderreader.h"
+#include <QString>
+#include <optional>
+
+// ── HeaderMetadataCache ───────────────────────────────────────────────────
+//
+// Keeps what was read from frame headers (XisfFrameData) and master files
+// (frame counts) across sessions, so re-importing logs whose frames have
+// not changed reads no headers at all.  Everything is kept in one binary
+// file under AppLocalDataLocation, loaded on first use and written back
+// by save().
+//
+// Entries are keyed by canonical path.  An entry is valid while the file's
+// size, modification time and inode match, so validating one costs a
+// single stat.  Only successful reads are stored.  All functions are
+// thread-safe.
+// ─────────────────────────────────────────────────────────────────────────
+class HeaderMetadataCache {
+public:
+    static constexpr int kMaxEntries = 200000;   // per kind
+
+    // Identity of a file's current contents, from one stat.
+    struct Stamp {
+        qint64  size{-1};
+        qint64  mtimeNs{0};
+        quint64 inode{0};   // 0 where the platform has none
+        quint64 device{0};
+    };
+
+    // nullopt if path does not exist.  Take the stamp before reading the
+    // file, so a file changed during the read is not cached as current.
+    static std::optional<Stamp> stamp(const QString &path);
+
+    static std::optional<XisfFrameData> frame(const QString &path,
+                                              const Stamp   &stamp);
+    static void storeFrame(const QString       &path,
+                           const Stamp         &stamp,
+                           const XisfFrameData &data);
+
+    static std::optional<int> masterCount(const QString &path,
+                                          const Stamp   &stamp);
+    static void storeMasterCount(const QString &path,
+                                 const Stamp   &stamp,
+                                 int            count);
+
+    // Writes the cache file if anything was stored since the last save.
+    // Failures are silently ignored.
+    static void save();
+
+    static QString cacheFilePath();
+};
@@ -0,0 +1,131 @@
+#include "headerpipeline.h"
+#include "batchheaderio.h"
+#include "xisfheaderengine.h"
+#include <QMutexLocker>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------
+// Stages
+// ---------------------------------------------------------------------------
+
+bool HeaderPipeline::stopping() const
+{
+    return m_stop || (m_cancel && m_cancel->loadAcquire());
+}
+
+void HeaderPipeline::locateLoop()
+{
+    QMutexLocker lk(&m_mutex);
+    for (;;) {
+        while (!stopping() && m_nextLocate < m_paths.size()
+               && m_nextLocate >= m_taken + kWindow)
+            m_changed.wait(&m_mutex);
+        if (stopping() || m_nextLocate >= m_paths.size()) break;
+
+        const qsizetype i = m_nextLocate++;
+        lk.unlock();
+        QString path  = m_paths.at(i);
+        auto    stamp = HeaderMetadataCache::stamp(path);
+        if (!stamp && m_relocate) {
+            const QString other = m_relocate(path);
+            if (!other.isEmpty()) {
+                stamp = HeaderMetadataCache::stamp(other);
+                if (stamp) path = other;
+            }
+        }
+        const bool read = stamp && !HeaderMetadataCache::frame(path, *stamp);
+        lk.relock();
+
+        m_items[size_t(i)].stamp = stamp;
+        if (stamp) m_items[size_t(i)].path = path;
+        if (read)
+            m_ioQueue.push_back(i);
+        else
+            m_ready[size_t(i)] = 1;
+        m_changed.wakeAll();
+    }
+    --m_locating;
+    m_changed.wakeAll();
+}
+
+void HeaderPipeline::ioLoop()
+{
+    QMutexLocker lk(&m_mutex);
+    for (;;) {
+        while (!stopping() && m_ioQueue.empty() && m_locating > 0)
+            m_changed.wait(&m_mutex);
+        if (stopping() || (m_ioQueue.empty() && m_locating == 0)) break;
+
+        // Lowest indices first: those are the frames the worker waits for.
+        std::sort(m_ioQueue.begin(), m_ioQueue.end());
+        const size_t n = qMin<size_t>(m_ioQueue.size(),
+                                      BatchHeaderIo::kQueueDepth);
+        const std::vector<qsizetype> batch(m_ioQueue.begin(),
+                                           m_ioQueue.begin() + n);
+        m_ioQueue.erase(m_ioQueue.begin(), m_ioQueue.begin() + n);
+        QStringList paths;
+        for (qsizetype i : batch) paths << m_items[size_t(i)].path;
+        lk.unlock();
+
+        QList<QByteArray> bytes = BatchHeaderIo::readPrefixes(
+            paths, XisfHeaderEngine::kSpeculativeBytes);
+        m_filesRead.fetchAndAddRelaxed(qint64(batch.size()));
+
+        lk.relock();
+        for (size_t k = 0; k < batch.size(); ++k) {
+            const qsizetype i = batch[k];
+            m_bytesRead.fetchAndAddRelaxed(bytes.at(qsizetype(k)).size());
+            if (i >= m_taken)
+                m_items[size_t(i)].bytes = std::move(bytes[qsizetype(k)]);
+            m_ready[size_t(i)] = 1;
+        }
+        m_changed.wakeAll();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+HeaderPipeline::HeaderPipeline(const QStringList &paths, int ioThreads,
+                               QAtomicInt *cancel, Relocate relocate)
+    : m_paths(paths)
+    , m_cancel(cancel)
+    , m_relocate(std::move(relocate))
+    , m_items(size_t(paths.size()))
+    , m_ready(size_t(paths.size()), 0)
+{
+    const int threads = qMax(1, ioThreads);
+    m_locating = threads;
+    for (int t = 0; t < threads; ++t) {
+        m_threads.emplace_back(QThread::create([this] { locateLoop(); }));
+        m_threads.emplace_back(QThread::create([this] { ioLoop(); }));
+    }
+    for (auto &t : m_threads) t->start();
+}
+
+HeaderPipeline::~HeaderPipeline()
+{
+    {
+        QMutexLocker lk(&m_mutex);
+        m_stop = true;
+        m_changed.wakeAll();
+    }
+    for (auto &t : m_threads) t->wait();
+}
+
+std::optional<HeaderPipeline::Item> HeaderPipeline::take(qsizetype i)
+{
+    QMutexLocker lk(&m_mutex);
+    for (qsizetype k = m_taken; k < i; ++k)
+        m_items[size_t(k)].bytes.clear();
+    m_taken = qMax(m_taken, i);
+    m_changed.wakeAll();
+
+    // Cancellation is a flag nobody signals, so wake up now and then.
+    while (!m_ready[size_t(i)]) {
+        if (stopping()) return std::nullopt;
+        m_changed.wait(&m_mutex, 100);
+    }
+    return std::move(m_items[size_t(i)]);
+}
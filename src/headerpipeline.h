@@ -0,0 +1,87 @@
+#pragma once
+#include "headermetadatacache.h"
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// ── HeaderPipeline ────────────────────────────────────────────────────────
+//
+// The locate and I/O stages of frame header resolution, running ahead of
+// FrameResolveWorker on their own threads:
+//
+//   locate  — stats each registered path and checks HeaderMetadataCache;
+//             missing and cached frames need no I/O and are ready at once.
+//             A frame missing at its own path is looked for once more at
+//             the path the caller's relocate function suggests.
+//   I/O     — reads the first kSpeculativeBytes of the remaining frames
+//             through BatchHeaderIo, a batch per thread.
+//
+// The parse/apply stage is the worker itself: it takes the frames in order,
+// parses the bytes and applies them.  Path searches for missing frames,
+// directory prompts, calibration lookups and debug logging all stay on that
+// one thread, so the results are the same as reading one frame after
+// another.
+//
+// Both stages share a window of kWindow frames ahead of the last frame
+// taken.  That bounds the queue between them and the bytes held.
+// ─────────────────────────────────────────────────────────────────────────
+class HeaderPipeline {
+public:
+    static constexpr qsizetype kWindow = 256;   // at most 16 MB of headers
+
+    struct Item {
+        std::optional<HeaderMetadataCache::Stamp> stamp;   // nullopt: missing
+        QString    path;        // where the stamp was taken; empty if missing
+        QByteArray bytes;       // empty if cached, missing or unreadable
+    };
+
+    // Another path to try for a frame missing at path, or empty.  Called
+    // on the locate threads.
+    using Relocate = std::function<QString(const QString &path)>;
+
+    // Starts ioThreads locate threads and ioThreads I/O threads.
+    HeaderPipeline(const QStringList &paths, int ioThreads, QAtomicInt *cancel,
+                   Relocate relocate = {});
+    ~HeaderPipeline();
+
+    // Blocks until frame i has passed both stages.  Frames are taken in
+    // increasing order; skipped frames are dropped.  nullopt if the import
+    // was cancelled first.
+    std::optional<Item> take(qsizetype i);
+
+    // I/O stage totals, for the debug log.
+    qint64 filesRead() const { return m_filesRead.loadRelaxed(); }
+    qint64 bytesRead() const { return m_bytesRead.loadRelaxed(); }
+
+private:
+    void locateLoop();
+    void ioLoop();
+    bool stopping() const;
+
+    const QStringList m_paths;
+    QAtomicInt       *m_cancel;
+    const Relocate    m_relocate;
+
+    mutable QMutex     m_mutex;
+    QWaitCondition     m_changed;       // any state below changed
+    std::vector<Item>  m_items;
+    std::vector<char>  m_ready;
+    std::vector<qsizetype> m_ioQueue;   // located frames awaiting I/O
+    qsizetype          m_nextLocate{0};
+    qsizetype          m_taken{0};      // frames before this are consumed
+                                        // or skipped
+    int                m_locating{0};   // locate threads still running
+    bool               m_stop{false};
+
+    QAtomicInteger<qint64> m_filesRead{0};
+    QAtomicInteger<qint64> m_bytesRead{0};
+
+    std::vector<std::unique_ptr<QThread>> m_threads;
+};
@@ -18,6 +18,8 @@ struct FlatBlock {
     QString masterBiasPath;   // from "Master bias:" inside the flat-calibration sub-block
 };
 
+// View over WbppLogScanner that exposes the Light calibration blocks and
+// the Flat calibration+integration pairs.
 class CalibrationLogParser {
 public:
     // Parses all Light calibration blocks in the given log file.
@@ -31,13 +33,4 @@ public:
 
 private:
     QString m_error;
-
-    // Parses a single Light calibration block (lines from Begin to End inclusive).
-    static CalibrationBlock parseBlock(const QStringList &lines);
-
-    // Parses a single Flat calibration block; returns the master bias path.
-    static QString parseFlatCalibrationBlock(const QStringList &lines);
-
-    // Extracts the master flat output path from a Flat integration block.
-    static QString parseFlatIntegrationBlock(const QStringList &lines);
 };
@@ -0,0 +1,120 @@
+#include "logfilereader.h"
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif
+
+LogFileReader::LogFileReader(const QString &filePath)
+    : m_file(filePath)
+{
+}
+
+LogFileReader::~LogFileReader()
+{
+    if (m_map) m_file.unmap(const_cast<uchar *>(m_map));
+}
+
+bool LogFileReader::open()
+{
+    if (!m_file.open(QIODevice::ReadOnly)) return false;
+    m_size = m_file.size();
+
+    if (m_size > 0) {
+        m_map = m_file.map(0, m_size);
+#ifdef Q_OS_UNIX
+        // Lines are consumed strictly front to back: let the kernel read
+        // ahead aggressively and drop pages behind us.
+        if (m_map)
+            ::madvise(const_cast<uchar *>(m_map),
+                      static_cast<size_t>(m_size), MADV_SEQUENTIAL);
+#endif
+    }
+    return true;
+}
+
+static QByteArrayView chopCr(const char *p, qsizetype n)
+{
+    if (n > 0 && p[n - 1] == '\r') --n;
+    return QByteArrayView(p, n);
+}
+
+bool LogFileReader::readLine(QByteArrayView &line)
+{
+    if (!m_map) return readLineWindowed(line);
+    if (m_pos >= m_size) return false;
+
+    const char *base  = reinterpret_cast<const char *>(m_map);
+    const char *start = base + m_pos;
+    const qint64 left = m_size - m_pos;
+    const void *nl = std::memchr(start, '\n', static_cast<size_t>(left));
+    const qint64 len = nl ? static_cast<const char *>(nl) - start : left;
+
+    m_lineOffset = m_pos;
+    m_pos += nl ? len + 1 : len;
+    line = chopCr(start, len);
+    return true;
+}
+
+bool LogFileReader::readLineWindowed(QByteArrayView &line)
+{
+    while (true) {
+        const char     *start = m_window.constData() + m_winPos;
+        const qsizetype left  = m_window.size() - m_winPos;
+        const void *nl = left > 0
+                             ? std::memchr(start, '\n', static_cast<size_t>(left))
+                             : nullptr;
+        if (nl) {
+            const qsizetype len = static_cast<const char *>(nl) - start;
+            m_lineOffset = m_winOffset + m_winPos;
+            m_winPos += len + 1;
+            line = chopCr(start, len);
+            return true;
+        }
+        if (m_eof) {
+            if (left <= 0) return false;
+            m_lineOffset = m_winOffset + m_winPos;
+            m_winPos = m_window.size();
+            line = chopCr(start, left);
+            return true;
+        }
+        if (!fillWindow()) m_eof = true;
+    }
+}
+
+bool LogFileReader::seek(qint64 offset)
+{
+    if (offset < 0 || offset > m_size) return false;
+    if (m_map) {
+        m_pos = offset;
+        return true;
+    }
+
+    // Still inside the current window: just move the cursor.
+    if (offset >= m_winOffset && offset <= m_winOffset + m_window.size()) {
+        m_winPos = static_cast<qsizetype>(offset - m_winOffset);
+        return true;
+    }
+    if (!m_file.seek(offset)) return false;
+    m_window.clear();
+    m_winPos    = 0;
+    m_winOffset = offset;
+    m_eof       = false;
+    return true;
+}
+
+bool LogFileReader::fillWindow()
+{
+    // Keep the unterminated tail of the current window and append the next
+    // chunk behind it.  The buffer only grows beyond kWindowBytes for a
+    // single line longer than the window.
+    m_window.remove(0, m_winPos);
+    m_winOffset += m_winPos;
+    m_winPos = 0;
+
+    const qsizetype keep = m_window.size();
+    m_window.resize(keep + kWindowBytes);
+    const qint64 got = m_file.read(m_window.data() + keep, kWindowBytes);
+    m_window.resize(keep + qMax<qint64>(got, 0));
+    return got > 0;
+}
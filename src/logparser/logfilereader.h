@@ -0,0 +1,62 @@
+#pragma once
+#include <QFile>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+
+// ── LogFileReader ─────────────────────────────────────────────────────────
+//
+// Constant-memory line reader for (very large) log files.
+//
+// The file is memory-mapped when possible, so lines are handed out as views
+// straight into the page cache and nothing is copied.  If mapping fails the
+// reader falls back to streaming the file through a fixed-size window; only
+// the current window (plus any line straddling its end) is held in memory.
+//
+// Either way peak memory does not grow with the size of the log.
+// ─────────────────────────────────────────────────────────────────────────
+class LogFileReader {
+public:
+    static constexpr qint64 kWindowBytes = 4 * 1024 * 1024;  // 4 MB
+
+    explicit LogFileReader(const QString &filePath);
+    ~LogFileReader();
+
+    LogFileReader(const LogFileReader &) = delete;
+    LogFileReader &operator=(const LogFileReader &) = delete;
+
+    bool    open();
+    QString errorString() const { return m_file.errorString(); }
+    bool    isMapped() const { return m_map != nullptr; }
+    qint64  size() const { return m_size; }
+
+    // Returns the next line without its "\n" / "\r\n" terminator.
+    // The view stays valid until the next call to readLine().
+    bool readLine(QByteArrayView &line);
+
+    // Byte offset in the file of the line last returned by readLine().
+    qint64 lineOffset() const { return m_lineOffset; }
+
+    // Byte offset of the next unread line.
+    qint64 position() const { return m_map ? m_pos : m_winOffset + m_winPos; }
+
+    // Repositions the reader so that the next readLine() returns the line
+    // starting at offset.  Offsets come from lineOffset().
+    bool seek(qint64 offset);
+
+private:
+    QFile        m_file;
+    const uchar *m_map{nullptr};
+    qint64       m_size{0};
+    qint64       m_pos{0};        // next unread byte (mapped mode)
+    qint64       m_lineOffset{0};
+
+    // Windowed fallback.
+    QByteArray   m_window;
+    qsizetype    m_winPos{0};     // next unread byte within m_window
+    qint64       m_winOffset{0};  // file offset of m_window[0]
+    bool         m_eof{false};
+
+    bool readLineWindowed(QByteArrayView &line);
+    bool fillWindow();
+};
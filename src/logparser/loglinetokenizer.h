@@ -0,0 +1,79 @@
+#pragma once
+#include "logfilereader.h"
+#include <QByteArrayView>
+
+// One log line as seen by the WBPP block parsers.
+struct LogLine {
+    QByteArrayView body;      // line text after the timestamp prefix
+    qint64         offset{0}; // byte offset of the line in the file
+    int            number{0}; // 0-based line number
+};
+
+// ── LogLineTokenizer ──────────────────────────────────────────────────────
+//
+// Splits a log into lines and strips PixInsight's fixed-width
+// "[YYYY-MM-DD hh:mm:ss] " prefix by checking the bytes in place: no regex,
+// no decoding and no allocation per line.  Bodies are views into the
+// LogFileReader buffer and stay valid until the next call to next().
+// ─────────────────────────────────────────────────────────────────────────
+class LogLineTokenizer {
+public:
+    static constexpr qsizetype kTimestampLen = 22;  // "[2024-01-31 23:59:59] "
+
+    explicit LogLineTokenizer(LogFileReader &reader) : m_reader(reader) {}
+
+    bool next(LogLine &line)
+    {
+        QByteArrayView raw;
+        if (!m_reader.readLine(raw)) return false;
+        line.body   = stripTimestamp(raw);
+        line.offset = m_reader.lineOffset();
+        line.number = m_number++;
+        m_raw       = raw;
+        return true;
+    }
+
+    // The last line including its timestamp prefix.
+    QByteArrayView raw() const { return m_raw; }
+
+    // Number of lines returned so far (the number of the next line).
+    int lineCount() const { return m_number; }
+
+    // Byte offset just past the last line returned.
+    qint64 endOffset() const { return m_reader.position(); }
+
+    // Continues at the line starting at offset, which is line lineNumber
+    // of the file.
+    bool seek(qint64 offset, int lineNumber)
+    {
+        if (!m_reader.seek(offset)) return false;
+        m_number = lineNumber;
+        return true;
+    }
+
+    static bool isTimestamp(QByteArrayView v)
+    {
+        if (v.size() < kTimestampLen) return false;
+        const char *p = v.data();
+        auto digits = [p](int from, int n) {
+            for (int i = from; i < from + n; ++i)
+                if (static_cast<unsigned>(p[i] - '0') > 9u) return false;
+            return true;
+        };
+        return p[0] == '[' && digits(1, 4) && p[5] == '-' && digits(6, 2)
+            && p[8] == '-' && digits(9, 2) && p[11] == ' ' && digits(12, 2)
+            && p[14] == ':' && digits(15, 2) && p[17] == ':' && digits(18, 2)
+            && p[20] == ']' && p[21] == ' ';
+    }
+
+    static QByteArrayView stripTimestamp(QByteArrayView v)
+    {
+        while (isTimestamp(v)) v = v.sliced(kTimestampLen);
+        return v;
+    }
+
+private:
+    LogFileReader &m_reader;
+    QByteArrayView m_raw;
+    int            m_number{0};
+};
@@ -3,6 +3,7 @@
 #include <QString>
 #include <QList>
 
+// View over WbppLogScanner that exposes the Light integration blocks.
 class PixInsightLogParser {
 public:
     // Returns one IntegrationGroup per non-LN-Reference Light integration
@@ -14,16 +15,4 @@ public:
 
 private:
     QString m_error;
-
-    // Parses a single integration block and populates the group's frame list.
-    // Returns false if no .xisf paths were found.
-    bool parseBlock(const QStringList &lines,
-                    IntegrationGroup  &grp,
-                    int                blockIdx);
-
-    static QStringList extractXisfPaths(const QStringList &lines,
-                                        int startLine,
-                                        bool isFastInteg);
-
-    static QString extractTarget(const QString &line);
 };
@@ -1,6 +1,134 @@
 #include "sirillogparser.h"
+#include "logfilereader.h"
+#include "fitsheaderreader.h"
+#include "debuglogger.h"
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
 #include <QTextStream>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+// Extensions Siril writes FITS frames with, in probing order.
+static const char *const kFrameExts[] = {
+    ".fit", ".fits", ".fts", ".fit.fz", ".fits.fz"
+};
+
+// Splits a Siril command line into words; double-quoted words may contain
+// spaces.
+static QStringList commandWords(const QString &cmd)
+{
+    QStringList words;
+    QString     cur;
+    bool        quoted = false;
+    bool        inWord = false;
+    for (const QChar c : cmd) {
+        if (c == u'"') {
+            quoted = !quoted;
+            inWord = true;
+        } else if (c.isSpace() && !quoted) {
+            if (inWord) words << cur;
+            cur.clear();
+            inWord = false;
+        } else {
+            cur += c;
+            inWord = true;
+        }
+    }
+    if (inWord) words << cur;
+    return words;
+}
+
+// Frames listed in a .seq file.  Returns false if the file cannot be read
+// or does not describe a sequence of individual FITS files.
+static bool readSeqFile(const QString &seqPath, const QString &dir,
+                        bool includedOnly, QStringList &frames)
+{
+    QFile f(seqPath);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+
+    // S 'name' beg number selnum fixed reference version [variable fz]
+    static const QRegularExpression sRe(
+        R"(^S\s+'([^']*)'\s+(-?\d+)\s+(\d+)\s+(\d+)\s+(\d+)(?:\s+(-?\d+)\s+(\d+)(?:\s+(\d+)\s+(\d+))?)?)");
+    static const QRegularExpression iRe(R"(^I\s+(\d+)\s+(\d+))");
+
+    QString name;
+    int     fixed = 0;
+    bool    fz    = false;
+    bool    haveS = false;
+    QList<int> numbers;
+
+    QTextStream in(&f);
+    QString line;
+    while (in.readLineInto(&line)) {
+        if (line.startsWith(u'#') || line.isEmpty()) continue;
+        if (!haveS) {
+            const auto m = sRe.match(line);
+            if (!m.hasMatch()) continue;
+            name  = m.captured(1);
+            fixed = m.captured(5).toInt();
+            fz    = m.captured(9) == QLatin1String("1");
+            haveS = true;
+            continue;
+        }
+        // SER, film and FITS-cube sequences keep all frames in one file.
+        if (line.startsWith(u'T') && line.size() > 1 && line.at(1) != u'-')
+            return false;
+        const auto m = iRe.match(line);
+        if (!m.hasMatch()) continue;
+        if (includedOnly && m.captured(2).toInt() == 0) continue;
+        numbers << m.captured(1).toInt();
+    }
+    if (!haveS) return false;
+
+    // Every frame of a sequence shares one extension; probe the first.
+    QString ext = QString::fromLatin1(fz ? ".fit.fz" : ".fit");
+    if (!numbers.isEmpty()) {
+        const QString stem = QDir(dir).filePath(
+            name + QStringLiteral("%1").arg(numbers.first(), fixed, 10, u'0'));
+        for (const char *e : kFrameExts)
+            if (QFile::exists(stem + QLatin1String(e))) {
+                ext = QLatin1String(e);
+                break;
+            }
+    }
+
+    const QDir d(dir);
+    for (int n : std::as_const(numbers))
+        frames << d.filePath(
+            name + QStringLiteral("%1").arg(n, fixed, 10, u'0') + ext);
+    return true;
+}
+
+// Fallback when no .seq file exists: every <seqName><digits>.<ext> in dir.
+static QStringList listSequenceFiles(const QString &dir, const QString &seqName)
+{
+    const QRegularExpression re(
+        QStringLiteral("^%1(\\d+)\\.(?:fit|fits|fts)(?:\\.fz)?$")
+            .arg(QRegularExpression::escape(seqName)),
+        QRegularExpression::CaseInsensitiveOption);
+
+    QList<QPair<int, QString>> numbered;
+    const QStringList entries = QDir(dir).entryList(QDir::Files);
+    for (const QString &fn : entries) {
+        const auto m = re.match(fn);
+        if (m.hasMatch())
+            numbered.append({ m.captured(1).toInt(), QDir(dir).filePath(fn) });
+    }
+    std::sort(numbered.begin(), numbered.end());
+
+    QStringList frames;
+    for (const auto &p : std::as_const(numbered)) frames << p.second;
+    return frames;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
 
 bool SirilLogParser::canParse(const QString &filePath) const
 {
@@ -9,11 +137,156 @@ bool SirilLogParser::canParse(const QString &filePath) const
     return QTextStream(&f).readLine().contains("Siril", Qt::CaseInsensitive);
 }
 
+QStringList SirilLogParser::sequenceFrames(const QString &dir,
+                                           const QString &seqName,
+                                           bool           includedOnly)
+{
+    // Siril accepts the sequence name with or without its trailing '_'.
+    QStringList frames;
+    for (const QString &candidate : { seqName, seqName + u'_' }) {
+        const QString seqPath = QDir(dir).filePath(candidate + QLatin1String(".seq"));
+        if (QFile::exists(seqPath)
+                && readSeqFile(seqPath, dir, includedOnly, frames))
+            return frames;
+        frames.clear();
+    }
+    frames = listSequenceFiles(dir, seqName);
+    if (frames.isEmpty() && !seqName.endsWith(u'_'))
+        frames = listSequenceFiles(dir, seqName + u'_');
+    return frames;
+}
+
 QList<IntegrationGroup> SirilLogParser::parse(const QString &filePath)
 {
-    Q_UNUSED(filePath)
-    m_error = QStringLiteral(
-        "Siril log parsing is not yet implemented. "
-        "Please use a PixInsight WBPP log for now.");
-    return {};
+    auto &dbg = DebugLogger::instance();
+    dbg.logSection(QStringLiteral("SirilLogParser"));
+
+    m_error.clear();
+
+    LogFileReader reader(filePath);
+    if (!reader.open()) {
+        m_error = QStringLiteral("Cannot open log: %1")
+                      .arg(reader.errorString());
+        dbg.logError(m_error);
+        return {};
+    }
+
+    static const QRegularExpression prefixRe(
+        R"(^(?:\d{1,2}:\d{2}:\d{2}:?\s*)?(?:log:\s*)?)");
+    static const QRegularExpression cwdRe(
+        R"(Setting CWD \(Current Working Directory\) to '(.*)')");
+    static const QRegularExpression commandRe(
+        R"(^(?:Running command:|>)\s*(.+)$)");
+
+    struct StackCmd {
+        QString dir;
+        QString seqName;
+        bool    includedOnly{false};
+    };
+    QList<StackCmd> stacks;
+
+    // Until the log names one, relative paths resolve next to the log.
+    QString cwd = QFileInfo(filePath).absolutePath();
+
+    QByteArrayView raw;
+    int lineNo = 0;
+    while (reader.readLine(raw)) {
+        ++lineNo;
+        // Only CWD notices and echoed commands matter; skip everything
+        // else before decoding the line.
+        if (!raw.contains(QByteArrayView("CWD"))
+                && !raw.contains(QByteArrayView("command"))
+                && !raw.contains(QByteArrayView("> ")))
+            continue;
+
+        QString s = QString::fromUtf8(raw);
+        s.remove(prefixRe);
+
+        if (const auto m = cwdRe.match(s); m.hasMatch()) {
+            cwd = m.captured(1);
+            continue;
+        }
+
+        const auto cm = commandRe.match(s);
+        if (!cm.hasMatch()) continue;
+        const QStringList words = commandWords(cm.captured(1).trimmed());
+        if (words.isEmpty()) continue;
+        const QString verb = words.first().toLower();
+
+        if (verb == QLatin1String("cd") && words.size() > 1) {
+            cwd = QDir::cleanPath(QDir(cwd).absoluteFilePath(words.at(1)));
+        } else if (verb == QLatin1String("stack") && words.size() > 1) {
+            StackCmd sc;
+            QString seq = words.at(1);
+            if (seq.endsWith(QLatin1String(".seq"), Qt::CaseInsensitive))
+                seq.chop(4);
+            const QFileInfo seqInfo(QDir(cwd).absoluteFilePath(seq));
+            sc.dir     = seqInfo.absolutePath();
+            sc.seqName = seqInfo.fileName();
+            for (int i = 2; i < words.size(); ++i)
+                if (words.at(i).startsWith(QLatin1String("-filter-incl")))
+                    sc.includedOnly = true;
+
+            // A re-stack of the same sequence replaces the earlier one.
+            stacks.erase(std::remove_if(stacks.begin(), stacks.end(),
+                             [&](const StackCmd &o) {
+                                 return o.dir == sc.dir
+                                     && o.seqName == sc.seqName;
+                             }),
+                         stacks.end());
+            stacks << sc;
+            dbg.logDecision(QStringLiteral("line %1: stack '%2' in '%3'")
+                                .arg(lineNo).arg(sc.seqName, sc.dir));
+        } else if (verb == QLatin1String("stackall")) {
+            dbg.logWarning(QStringLiteral(
+                "line %1: stackall is not supported — skipped").arg(lineNo));
+        }
+    }
+
+    QList<IntegrationGroup> groups;
+    for (int i = 0; i < stacks.size(); ++i) {
+        const StackCmd &sc = stacks.at(i);
+        const QStringList frames =
+            sequenceFrames(sc.dir, sc.seqName, sc.includedOnly);
+        dbg.logResult(QStringLiteral("stack[%1].frames").arg(i),
+                      QString::number(frames.size()));
+        if (frames.isEmpty()) {
+            dbg.logWarning(QStringLiteral("No frames found for sequence "
+                                          "'%1' in '%2'")
+                               .arg(sc.seqName, sc.dir));
+            continue;
+        }
+
+        IntegrationGroup grp;
+        grp.sourceLogFile = filePath;
+        grp.sessionIndex  = i;
+
+        // Exposure and filter are per sequence; one header is enough.
+        QString filter;
+        if (const auto hdr = FitsHeaderReader::read(frames.first())) {
+            grp.exposureSec = hdr->exposureSec;
+            filter          = hdr->filter;
+        }
+
+        for (const QString &path : frames) {
+            AcquisitionFrame frame;
+            frame.registeredPath = path;
+            frame.exposureSec    = grp.exposureSec;
+            frame.filter         = filter;
+            grp.frames << frame;
+        }
+        groups << grp;
+    }
+
+    if (groups.isEmpty()) {
+        m_error = stacks.isEmpty()
+            ? QStringLiteral("No stack commands found in log.")
+            : QStringLiteral("None of the stacked sequences could be "
+                             "found on disk.");
+        dbg.logWarning(m_error);
+    }
+
+    dbg.logResult(QStringLiteral("groupsFound"),
+                  QString::number(groups.size()));
+    return groups;
 }
@@ -1,11 +1,32 @@
 #pragma once
 #include "logparserbase.h"
+#include <QStringList>
 
+// ── SirilLogParser ────────────────────────────────────────────────────────
+//
+// Reads a Siril log (GUI "Save log" output or a siril-cli transcript) in a
+// single streaming pass and returns one IntegrationGroup per `stack`
+// command.  The log itself only names the stacked sequence, so the frame
+// list comes from the sequence's .seq file (falling back to listing the
+// working directory) and exposure/filter come from the primary FITS header
+// of the first frame; no pixel data is read.
+//
+// The working directory is tracked from "Setting CWD" lines and `cd`
+// commands.  A sequence that is stacked more than once yields only its
+// last stack, so re-runs with different parameters are not counted twice.
+// ─────────────────────────────────────────────────────────────────────────
 class SirilLogParser : public ILogParser {
 public:
     QList<IntegrationGroup> parse(const QString &filePath) override;
     QString errorString() const override { return m_error; }
     bool canParse(const QString &filePath) const override;
+
+    // Frame paths of sequence seqName in dir.  With includedOnly, frames
+    // excluded in the .seq file are left out (`stack ... -filter-incl`).
+    static QStringList sequenceFrames(const QString &dir,
+                                      const QString &seqName,
+                                      bool           includedOnly);
+
 private:
     QString m_error;
 };
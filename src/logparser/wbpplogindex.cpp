@@ -0,0 +1,114 @@
+#include "wbpplogindex.h"
+#include "wbppmarkermatcher.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct KindMarker {
+    WbppLogIndex::Kind kind;
+    WbppMarker         marker;
+};
+
+constexpr KindMarker kKindMarkers[] = {
+    { WbppLogIndex::LightIntegrationBegin, WbppMarker::IntegrationBegin },
+    { WbppLogIndex::LightIntegrationBegin, WbppMarker::FastIntegrationBegin },
+    { WbppLogIndex::LightIntegrationEnd,   WbppMarker::IntegrationEnd },
+    { WbppLogIndex::LightIntegrationEnd,   WbppMarker::FastIntegrationEnd },
+    { WbppLogIndex::LightCalBegin,         WbppMarker::LightCalBegin },
+    { WbppLogIndex::LightCalEnd,           WbppMarker::LightCalEnd },
+    { WbppLogIndex::FlatCalBegin,          WbppMarker::FlatCalBegin },
+    { WbppLogIndex::FlatCalEnd,            WbppMarker::FlatCalEnd },
+    { WbppLogIndex::FlatIntegrationBegin,  WbppMarker::FlatIntegrationBegin },
+    { WbppLogIndex::FlatIntegrationEnd,    WbppMarker::FlatIntegrationEnd },
+};
+
+} // namespace
+
+bool WbppLogIndex::isSignatureLine(QByteArrayView raw)
+{
+    return raw.contains(QByteArrayView("PixInsight Core")) ||
+           raw.contains(QByteArrayView("Weighted Batch Preprocessing")) ||
+           raw.contains(QByteArrayView("fast integration"));
+}
+
+void WbppLogIndex::scan(LogLineTokenizer &tokenizer, qint64 endOffset)
+{
+    const WbppMarkerMatcher &matcher = WbppMarkerMatcher::instance();
+
+    LogLine line;
+    while (tokenizer.next(line)) {
+        if (endOffset >= 0 && line.offset >= endOffset) {
+            m_lineCount    = line.number;
+            m_indexedBytes = line.offset;
+            return;
+        }
+        if (line.number < kSignatureLines && !m_isWbppLog
+                && isSignatureLine(tokenizer.raw()))
+            m_isWbppLog = true;
+
+        // Every block marker starts with "* "; skip the automaton for the
+        // (vast majority of) lines without an asterisk.
+        const QByteArrayView s = line.body;
+        if (s.isEmpty() || !std::memchr(s.data(), '*', static_cast<size_t>(s.size())))
+            continue;
+
+        const WbppMarkerHits hits = matcher.match(s);
+        if (hits.isEmpty()) continue;
+        for (const KindMarker &km : kKindMarkers)
+            if (hits.has(km.marker))
+                m_markers[km.kind].append(WbppMarkerPos{line.offset, line.number});
+    }
+    m_lineCount    = tokenizer.lineCount();
+    m_indexedBytes = tokenizer.endOffset();
+}
+
+const WbppMarkerPos *WbppLogIndex::nextAfter(Kind kind, int line) const
+{
+    const QList<WbppMarkerPos> &v = m_markers[kind];
+    const auto it = std::upper_bound(
+        v.cbegin(), v.cend(), line,
+        [](int l, const WbppMarkerPos &p) { return l < p.line; });
+    return it == v.cend() ? nullptr : &*it;
+}
+
+const WbppMarkerPos *WbppLogIndex::nextAnyAfter(int line) const
+{
+    const WbppMarkerPos *best = nullptr;
+    for (int k = 0; k < KindCount; ++k) {
+        const WbppMarkerPos *p = nextAfter(static_cast<Kind>(k), line);
+        if (p && (!best || p->line < best->line)) best = p;
+    }
+    return best;
+}
+
+QDataStream &operator<<(QDataStream &out, const WbppLogIndex &idx)
+{
+    out << idx.m_isWbppLog << qint32(idx.m_lineCount) << idx.m_indexedBytes;
+    for (const QList<WbppMarkerPos> &v : idx.m_markers) {
+        out << qint32(v.size());
+        for (const WbppMarkerPos &p : v)
+            out << p.offset << qint32(p.line);
+    }
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, WbppLogIndex &idx)
+{
+    qint32 lineCount = 0;
+    in >> idx.m_isWbppLog >> lineCount >> idx.m_indexedBytes;
+    idx.m_lineCount = lineCount;
+    for (QList<WbppMarkerPos> &v : idx.m_markers) {
+        qint32 n = 0;
+        in >> n;
+        v.clear();
+        for (qint32 i = 0; i < n && in.status() == QDataStream::Ok; ++i) {
+            WbppMarkerPos p;
+            qint32 line = 0;
+            in >> p.offset >> line;
+            p.line = line;
+            v.append(p);
+        }
+    }
+    return in;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "loglinetokenizer.h"
+#include <QDataStream>
+#include <QList>
+#include <array>
+
+// Location of one block marker line in a log.
+struct WbppMarkerPos {
+    qint64 offset{0};   // byte offset of the line start
+    int    line{0};     // 0-based line number
+};
+
+// ── WbppLogIndex ──────────────────────────────────────────────────────────
+//
+// Structure of a WBPP log: the position of every Begin/End block marker,
+// one sorted array per marker kind, collected in a single pass.  Block
+// boundaries, the Light calibration summary tail and Flat calibration →
+// integration pairing are then binary searches instead of forward rescans,
+// and each block can be re-read on its own by seeking to its Begin line.
+//
+// The index is small (a few entries per block) and is kept with the scan
+// result so a cached log never has to be re-indexed.
+// ─────────────────────────────────────────────────────────────────────────
+class WbppLogIndex {
+public:
+    enum Kind {
+        LightIntegrationBegin,   // includes "fast integration"
+        LightIntegrationEnd,
+        LightCalBegin,
+        LightCalEnd,
+        FlatCalBegin,
+        FlatCalEnd,
+        FlatIntegrationBegin,
+        FlatIntegrationEnd,
+        KindCount
+    };
+
+    // Indexes the remaining lines of tokenizer that start before endOffset
+    // (all of them when endOffset is negative).  Positions must be added in
+    // file order, so a later call has to continue where the previous one
+    // stopped: seek the tokenizer to indexedBytes() / lineCount() first.
+    void scan(LogLineTokenizer &tokenizer, qint64 endOffset = -1);
+
+    // True if raw, one of the first kSignatureLines lines of a log, marks
+    // it as a PixInsight / WBPP log.
+    static constexpr int kSignatureLines = 10;
+    static bool isSignatureLine(QByteArrayView raw);
+
+    bool   isWbppLog()    const { return m_isWbppLog; }
+    int    lineCount()    const { return m_lineCount; }
+    qint64 indexedBytes() const { return m_indexedBytes; }
+
+    const QList<WbppMarkerPos> &markers(Kind kind) const
+    {
+        return m_markers[kind];
+    }
+
+    // First marker of the given kind on a line after `line`, or nullptr.
+    const WbppMarkerPos *nextAfter(Kind kind, int line) const;
+
+    // First marker of any kind on a line after `line`, or nullptr.
+    const WbppMarkerPos *nextAnyAfter(int line) const;
+
+    friend QDataStream &operator<<(QDataStream &out, const WbppLogIndex &idx);
+    friend QDataStream &operator>>(QDataStream &in, WbppLogIndex &idx);
+
+private:
+    std::array<QList<WbppMarkerPos>, KindCount> m_markers;
+    int    m_lineCount{0};
+    qint64 m_indexedBytes{0};   // offset of the first line not indexed
+    bool   m_isWbppLog{false};  // PI/WBPP signature in the first lines
+};
@@ -0,0 +1,1025 @@
+#include "wbpplogscanner.h"
+#include "logfilereader.h"
+#include "loglinetokenizer.h"
+#include "wbppmarkermatcher.h"
+#include "wbppscandiskcache.h"
+#include "settings/appsettings.h"
+#include "debuglogger.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QRegularExpression>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <vector>
+
+// Lines arrive as undecoded byte views together with the set of anchors
+// WbppMarkerMatcher found on them.  A parser only decodes a line (and runs a
+// field regex) when the field's anchor is present, so the vast majority of
+// lines are never converted.
+static QString decode(QByteArrayView v)
+{
+    return QString::fromUtf8(v);
+}
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// In-memory scan cache
+// ---------------------------------------------------------------------------
+
+struct CacheEntry {
+    qint64         size{-1};
+    QDateTime      modified;
+    QString        targetKeywords;   // extraction depends on this setting
+    WbppScanResult result;
+};
+
+QMutex                     g_cacheMutex;
+QHash<QString, CacheEntry> g_cache;
+
+// ---------------------------------------------------------------------------
+// "* Begin/End (fast) integration of Light frames"
+// ---------------------------------------------------------------------------
+
+class IntegrationBlockParser {
+public:
+    IntegrationBlockParser(int blockIdx, const QRegularExpression &targetRe)
+        : m_blockIdx(blockIdx), m_targetRe(targetRe) {}
+
+    void feed(QByteArrayView s, WbppMarkerHits hits);
+
+    bool isLnReference() const { return m_isLnReference; }
+
+    // Returns false if no .xisf paths were found.
+    bool finish(IntegrationGroup &grp) const;
+
+private:
+    int                       m_blockIdx;
+    const QRegularExpression &m_targetRe;
+
+    QString     m_filter;
+    double      m_exposureSec{0};
+    QString     m_logTarget;
+    bool        m_targetFromLog{false};
+
+    bool        m_imagesSeen{false};   // II.images / FI.targets opened
+    bool        m_imagesDone{false};   // closing "];" seen
+    QStringList m_paths;
+
+    bool        m_writingMasterSeen{false};
+    bool        m_checkNextForLn{false};
+    bool        m_isLnReference{false};
+};
+
+void IntegrationBlockParser::feed(QByteArrayView s, WbppMarkerHits hits)
+{
+    auto &dbg = DebugLogger::instance();
+
+    static const QRegularExpression filterRe(R"(Filter\s*:\s*(.+))");
+    static const QRegularExpression exposureRe(R"(Exposure\s*:\s*([\d.]+)s)");
+    static const QRegularExpression keywordsRe(R"(Keywords\s*:\s*\[(.+)\])");
+    static const QRegularExpression imagesBeginRe(R"(II\.images\s*=\s*\[)");
+    static const QRegularExpression targetsBeginRe(R"(FI\.targets\s*=\s*\[)");
+    static const QRegularExpression pathRe(
+        R"(\[(?:true|false),\s*\"([^\"]+\.xisf)\")");
+
+    // Local Normalization reference blocks: the master file name follows
+    // the first "* Writing master Light frame:" line.
+    if (m_checkNextForLn) {
+        m_checkNextForLn = false;
+        const QString fname = QFileInfo(decode(s.trimmed())).fileName();
+        if (fname.startsWith(QLatin1String("LN_Reference_"),
+                             Qt::CaseInsensitive))
+            m_isLnReference = true;
+    }
+    if (!m_writingMasterSeen && hits.has(WbppMarker::WritingMasterLight)) {
+        m_writingMasterSeen = true;
+        m_checkNextForLn    = true;
+    }
+
+    if (hits.has(WbppMarker::Filter)) {
+        const QString line = decode(s);
+        if (auto m = filterRe.match(line); m.hasMatch()) {
+            m_filter = m.captured(1).trimmed();
+            dbg.logPattern(QStringLiteral("filterRe"),
+                           filterRe.pattern(), true, line.trimmed().left(100));
+            dbg.logResult(
+                QStringLiteral("block[%1].filter").arg(m_blockIdx), m_filter);
+        }
+    }
+
+    if (hits.has(WbppMarker::Exposure)) {
+        const QString line = decode(s);
+        if (auto m = exposureRe.match(line); m.hasMatch()) {
+            m_exposureSec = m.captured(1).trimmed().toDouble();
+            dbg.logPattern(QStringLiteral("exposureRe"),
+                           exposureRe.pattern(), true, line.trimmed().left(100));
+            dbg.logResult(
+                QStringLiteral("block[%1].exposure").arg(m_blockIdx),
+                QString::number(m_exposureSec));
+        }
+    }
+
+    if (hits.has(WbppMarker::Keywords)) {
+        const QString line = decode(s);
+        if (keywordsRe.match(line).hasMatch()) {
+            dbg.logPattern(QStringLiteral("keywordsRe"),
+                           keywordsRe.pattern(), true, line.trimmed().left(100));
+            const auto m = m_targetRe.pattern().isEmpty()
+                               ? QRegularExpressionMatch()
+                               : m_targetRe.match(line);
+            const QString extracted =
+                m.hasMatch() ? m.captured(1).trimmed() : QString();
+            if (extracted.isEmpty()) {
+                dbg.logDecision(
+                    QStringLiteral("block[%1] keywords line matched but no "
+                                   "target keyword found in: %2")
+                        .arg(m_blockIdx).arg(line.trimmed().left(100)));
+            } else {
+                m_logTarget     = extracted;
+                m_targetFromLog = true;
+                dbg.logResult(
+                    QStringLiteral("block[%1].target").arg(m_blockIdx),
+                    m_logTarget);
+                dbg.logDecision(
+                    QStringLiteral("block[%1] target set from WBPP log "
+                                   "keyword — OBJECT header will not "
+                                   "override it").arg(m_blockIdx));
+            }
+        }
+    }
+
+    // Registered frame list: the first II.images / FI.targets array.
+    if (!m_imagesSeen) {
+        if (hits.has(WbppMarker::ImagesArray)) {
+            const QString line = decode(s);
+            if (imagesBeginRe.match(line).hasMatch()) {
+                m_imagesSeen = true;
+                dbg.logPattern(QStringLiteral("imagesBeginRe"),
+                               imagesBeginRe.pattern(), true,
+                               line.trimmed().left(80));
+            }
+        } else if (hits.has(WbppMarker::TargetsArray)) {
+            const QString line = decode(s);
+            if (targetsBeginRe.match(line).hasMatch()) {
+                m_imagesSeen = true;
+                dbg.logPattern(QStringLiteral("targetsBeginRe"),
+                               targetsBeginRe.pattern(), true,
+                               line.trimmed().left(80));
+            }
+        }
+        return;
+    }
+    if (m_imagesDone) return;
+    if (s.trimmed().startsWith(QByteArrayView("];"))) {
+        m_imagesDone = true;
+        return;
+    }
+    if (hits.has(WbppMarker::Xisf)) {
+        if (auto m = pathRe.match(decode(s)); m.hasMatch())
+            m_paths << m.captured(1);
+    }
+}
+
+bool IntegrationBlockParser::finish(IntegrationGroup &grp) const
+{
+    grp.exposureSec   = m_exposureSec;
+    grp.logTarget     = m_logTarget;
+    grp.targetFromLog = m_targetFromLog;
+
+    if (m_paths.isEmpty()) return false;
+
+    DebugLogger::instance().logResult(
+        QStringLiteral("block[%1].xisfCount").arg(m_blockIdx),
+        QString::number(m_paths.size()));
+
+    // One AcquisitionFrame per registered path, pre-populated with the
+    // data available from the log.
+    grp.frames.reserve(m_paths.size());
+    for (const QString &p : m_paths) {
+        AcquisitionFrame frame;
+        frame.registeredPath = p;
+        frame.exposureSec    = grp.exposureSec;
+        frame.logTarget      = grp.logTarget;
+        frame.targetFromLog  = grp.targetFromLog;
+        frame.filter         = m_filter;  // log-derived; may be overridden
+                                          // by FILTER keyword from XISF header
+        grp.frames << frame;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// "* Begin/End calibration of Light frames"
+// ---------------------------------------------------------------------------
+
+class LightCalibrationParser {
+public:
+    void feed(QByteArrayView s, WbppMarkerHits hits);
+    CalibrationBlock finish();
+
+private:
+    CalibrationBlock m_blk;
+    bool             m_darkEnabled{false};
+    bool             m_flatEnabled{false};
+};
+
+void LightCalibrationParser::feed(QByteArrayView bytes, WbppMarkerHits hits)
+{
+    if (!hits.has(WbppMarker::ICMaster) && !hits.has(WbppMarker::MasterBias))
+        return;
+
+    static const QRegularExpression darkEnabledRe(
+        R"(IC\.masterDarkEnabled\s*=\s*(true|false))");
+    static const QRegularExpression flatEnabledRe(
+        R"(IC\.masterFlatEnabled\s*=\s*(true|false))");
+    static const QRegularExpression biasEnabledRe(
+        R"(IC\.masterBiasEnabled\s*=\s*(true|false))");
+    static const QRegularExpression darkPathRe(
+        R"(IC\.masterDarkPath\s*=\s*\"([^\"]+)\")");
+    static const QRegularExpression flatPathRe(
+        R"(IC\.masterFlatPath\s*=\s*\"([^\"]+)\")");
+    static const QRegularExpression biasPathRe(
+        R"(IC\.masterBiasPath\s*=\s*\"([^\"]+)\")");
+    static const QRegularExpression biasSummaryRe(
+        R"(Master bias:\s*(.+\.xisf))");
+
+    auto &dbg = DebugLogger::instance();
+    const QString s = decode(bytes);
+
+    if (auto m = darkEnabledRe.match(s); m.hasMatch()) {
+        m_darkEnabled = (m.captured(1) == QLatin1String("true"));
+        dbg.logPattern(QStringLiteral("darkEnabledRe"),
+                       darkEnabledRe.pattern(), true, s.trimmed().left(80));
+        dbg.logDecision(QStringLiteral("masterDarkEnabled = %1")
+                            .arg(m_darkEnabled ? "true" : "false"));
+    }
+    if (auto m = flatEnabledRe.match(s); m.hasMatch()) {
+        m_flatEnabled = (m.captured(1) == QLatin1String("true"));
+        dbg.logPattern(QStringLiteral("flatEnabledRe"),
+                       flatEnabledRe.pattern(), true, s.trimmed().left(80));
+        dbg.logDecision(QStringLiteral("masterFlatEnabled = %1")
+                            .arg(m_flatEnabled ? "true" : "false"));
+    }
+    if (auto m = biasEnabledRe.match(s); m.hasMatch()) {
+        const bool biasEnabled = (m.captured(1) == QLatin1String("true"));
+        dbg.logPattern(QStringLiteral("biasEnabledRe"),
+                       biasEnabledRe.pattern(), true, s.trimmed().left(80));
+        dbg.logDecision(QStringLiteral("masterBiasEnabled = %1")
+                            .arg(biasEnabled ? "true" : "false"));
+    }
+
+    if (m_darkEnabled && m_blk.masterDarkPath.isEmpty()) {
+        if (auto m = darkPathRe.match(s); m.hasMatch()) {
+            m_blk.masterDarkPath = m.captured(1).trimmed();
+            dbg.logPattern(QStringLiteral("darkPathRe"),
+                           darkPathRe.pattern(), true, s.trimmed().left(100));
+            dbg.logResult(QStringLiteral("masterDarkPath"), m_blk.masterDarkPath);
+        }
+    }
+    if (m_flatEnabled && m_blk.masterFlatPath.isEmpty()) {
+        if (auto m = flatPathRe.match(s); m.hasMatch()) {
+            m_blk.masterFlatPath = m.captured(1).trimmed();
+            dbg.logPattern(QStringLiteral("flatPathRe"),
+                           flatPathRe.pattern(), true, s.trimmed().left(100));
+            dbg.logResult(QStringLiteral("masterFlatPath"), m_blk.masterFlatPath);
+        }
+    }
+    if (m_blk.masterBiasPath.isEmpty()) {
+        if (auto m = biasPathRe.match(s); m.hasMatch()) {
+            m_blk.masterBiasPath = m.captured(1).trimmed();
+            dbg.logPattern(QStringLiteral("biasPathRe"),
+                           biasPathRe.pattern(), true, s.trimmed().left(100));
+            dbg.logResult(QStringLiteral("masterBiasPath (script)"),
+                          m_blk.masterBiasPath);
+        } else if (auto m = biasSummaryRe.match(s); m.hasMatch()) {
+            QString candidate = m.captured(1).trimmed();
+            if (!candidate.isEmpty() &&
+                    candidate.compare(QLatin1String("none"),
+                                      Qt::CaseInsensitive) != 0) {
+                m_blk.masterBiasPath = candidate;
+                dbg.logPattern(QStringLiteral("biasSummaryRe"),
+                               biasSummaryRe.pattern(), true,
+                               s.trimmed().left(100));
+                dbg.logResult(QStringLiteral("masterBiasPath (summary)"),
+                              m_blk.masterBiasPath);
+            }
+        }
+    }
+}
+
+CalibrationBlock LightCalibrationParser::finish()
+{
+    auto &dbg = DebugLogger::instance();
+
+    if (!m_darkEnabled && !m_blk.masterDarkPath.isEmpty()) {
+        dbg.logDecision(QStringLiteral("darkEnabled=false → clearing masterDarkPath"));
+        m_blk.masterDarkPath.clear();
+    }
+    if (!m_flatEnabled && !m_blk.masterFlatPath.isEmpty()) {
+        dbg.logDecision(QStringLiteral("flatEnabled=false → clearing masterFlatPath"));
+        m_blk.masterFlatPath.clear();
+    }
+
+    dbg.logResult(QStringLiteral("masterDark"), m_blk.masterDarkPath.isEmpty()
+                      ? QStringLiteral("(none)") : m_blk.masterDarkPath);
+    dbg.logResult(QStringLiteral("masterFlat"), m_blk.masterFlatPath.isEmpty()
+                      ? QStringLiteral("(none)") : m_blk.masterFlatPath);
+    dbg.logResult(QStringLiteral("masterBias"), m_blk.masterBiasPath.isEmpty()
+                      ? QStringLiteral("(none)") : m_blk.masterBiasPath);
+    return m_blk;
+}
+
+// ---------------------------------------------------------------------------
+// "* Begin calibration of Flat frames" → master bias path
+// ---------------------------------------------------------------------------
+
+class FlatCalibrationParser {
+public:
+    void feed(QByteArrayView s, WbppMarkerHits hits);
+    bool hasResult() const { return m_found; }
+    QString biasPath() const { return m_biasPath; }
+
+private:
+    QString m_biasPath;
+    bool    m_found{false};
+};
+
+void FlatCalibrationParser::feed(QByteArrayView bytes, WbppMarkerHits hits)
+{
+    if (m_found) return;
+
+    static const QRegularExpression biasSummaryRe(
+        R"(Master bias:\s*(.+\.xisf))");
+    static const QRegularExpression biasPathRe(
+        R"(IC\.masterBiasPath\s*=\s*\"([^\"]+)\")");
+
+    auto &dbg = DebugLogger::instance();
+
+    if (hits.has(WbppMarker::ICMasterBiasPath)) {
+        const QString s = decode(bytes);
+        if (auto m = biasPathRe.match(s); m.hasMatch()) {
+            dbg.logPattern(QStringLiteral("biasPathRe (flat cal)"),
+                           biasPathRe.pattern(), true, s.trimmed().left(100));
+            m_biasPath = m.captured(1).trimmed();
+            m_found    = true;
+            return;
+        }
+    }
+    if (hits.has(WbppMarker::MasterBias)) {
+        const QString s = decode(bytes);
+        if (auto m = biasSummaryRe.match(s); m.hasMatch()) {
+            QString v = m.captured(1).trimmed();
+            if (!v.isEmpty() &&
+                    v.compare(QLatin1String("none"), Qt::CaseInsensitive) != 0) {
+                dbg.logPattern(QStringLiteral("biasSummaryRe (flat cal)"),
+                               biasSummaryRe.pattern(), true,
+                               s.trimmed().left(100));
+                m_biasPath = v;
+                m_found    = true;
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// "* Begin integration of Flat frames" → master flat output path
+// ---------------------------------------------------------------------------
+
+class FlatIntegrationParser {
+public:
+    void feed(QByteArrayView s, WbppMarkerHits hits);
+    bool hasResult() const { return m_found; }
+    QString masterFlatPath() const { return m_flatPath; }
+
+private:
+    QString m_flatPath;
+    bool    m_found{false};
+    bool    m_nextLineIsPath{false};
+};
+
+void FlatIntegrationParser::feed(QByteArrayView raw, WbppMarkerHits hits)
+{
+    if (m_found) return;
+
+    static const QRegularExpression addMasterRe(
+        R"(Add the master file:\s*(.+\.xisf))");
+
+    auto &dbg = DebugLogger::instance();
+    const QByteArrayView s = raw.trimmed();
+
+    if (m_nextLineIsPath) {
+        if (!s.isEmpty() && s.endsWith(QByteArrayView(".xisf"))) {
+            m_flatPath = decode(s);
+            m_found    = true;
+            dbg.logDecision(
+                QStringLiteral("Flat integration master: path on next line = %1")
+                    .arg(m_flatPath));
+            return;
+        }
+        m_nextLineIsPath = false;
+    }
+    if (hits.has(WbppMarker::WritingMasterFlat)) {
+        dbg.logPattern(QStringLiteral("writingMasterFlat"),
+                       QStringLiteral("Writing master Flat frame"), true,
+                       decode(s).left(100));
+        m_nextLineIsPath = true;
+        return;
+    }
+    if (hits.has(WbppMarker::AddMasterFile)) {
+        const QString line = decode(s);
+        if (auto m = addMasterRe.match(line); m.hasMatch()) {
+            dbg.logPattern(QStringLiteral("addMasterRe"),
+                           addMasterRe.pattern(), true, line.left(100));
+            m_flatPath = m.captured(1).trimmed();
+            m_found    = true;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Index-driven block parsing
+// ---------------------------------------------------------------------------
+
+constexpr int kToEof = std::numeric_limits<int>::max();
+
+// Replays a line range of the log, located through WbppLogIndex, through a
+// block parser.
+class LineRange {
+public:
+    explicit LineRange(LogFileReader &reader) : m_tokenizer(reader) {}
+
+    // Calls fn(body, hits, lineNo) for every line from `from` up to and
+    // including lastLine.
+    template <typename Fn>
+    void forEach(const WbppMarkerPos &from, int lastLine, Fn &&fn)
+    {
+        if (!m_tokenizer.seek(from.offset, from.line)) return;
+        const WbppMarkerMatcher &matcher = WbppMarkerMatcher::instance();
+        LogLine line;
+        while (m_tokenizer.next(line) && line.number <= lastLine)
+            fn(line.body, matcher.match(line.body), line.number);
+    }
+
+private:
+    LogLineTokenizer m_tokenizer;
+};
+
+using BlockJob = std::function<void(LineRange &)>;
+
+// Runs every job with a LineRange of its thread's own.  Jobs are claimed in
+// order by the calling thread and by any global pool threads that are idle
+// right now; when parallel is false the caller runs them all, in order.
+void runJobs(const std::vector<BlockJob> &jobs, LogFileReader &callerReader,
+             const QString &filePath, bool parallel)
+{
+    std::atomic<size_t> next{0};
+    auto work = [&jobs, &next](LineRange &lines) {
+        for (size_t i; (i = next.fetch_add(1)) < jobs.size(); )
+            jobs[i](lines);
+    };
+
+    QSemaphore helpersDone;
+    int        helpers = 0;
+    if (parallel) {
+        QThreadPool *pool = QThreadPool::globalInstance();
+        const int want =
+            static_cast<int>(qMin<size_t>(jobs.size(),
+                                          size_t(pool->maxThreadCount()))) - 1;
+        while (helpers < want) {
+            const bool started = pool->tryStart([&work, &helpersDone, &filePath]() {
+                LogFileReader reader(filePath);
+                if (reader.open()) {
+                    LineRange lines(reader);
+                    work(lines);
+                }
+                helpersDone.release();
+            });
+            if (!started) break;
+            ++helpers;
+        }
+    }
+
+    LineRange lines(callerReader);
+    work(lines);
+    helpersDone.acquire(helpers);
+}
+
+// Target keyword extractor, compiled once per scan.
+QRegularExpression targetKeywordRe()
+{
+    const QStringList keywords = AppSettings::instance().targetKeywords();
+    if (keywords.isEmpty()) return {};
+
+    QStringList escaped;
+    for (const QString &kw : keywords)
+        escaped << QRegularExpression::escape(kw);
+    return QRegularExpression(
+        QStringLiteral(R"((?:%1)\s*:\s*([^\],]+))").arg(escaped.join('|')),
+        QRegularExpression::CaseInsensitiveOption);
+}
+
+// ── Light integration ───────────────────────────────────────────────────
+
+struct IntegrationJob {
+    WbppMarkerPos    begin;
+    int              endLine{0};
+    int              blockIdx{0};
+    bool             accepted{false};
+    IntegrationGroup grp;
+};
+
+// With growing == true the log is still being written: blocks whose
+// result could still change are left for a later call, and so is
+// everything after them.
+
+QList<IntegrationJob> planLightIntegration(const WbppLogIndex &idx,
+                                           bool                growing)
+{
+    QList<IntegrationJob> jobs;
+    int after = -1;        // last line of the previous block
+    for (const WbppMarkerPos &begin :
+             idx.markers(WbppLogIndex::LightIntegrationBegin)) {
+        if (begin.line <= after) continue;   // Begin inside an earlier block
+
+        const WbppMarkerPos *end =
+            idx.nextAfter(WbppLogIndex::LightIntegrationEnd, begin.line);
+        if (!end) {
+            if (!growing)
+                DebugLogger::instance().logWarning(
+                    QStringLiteral("No matching End marker — block %1 skipped")
+                        .arg(jobs.size()));
+            break;
+        }
+        IntegrationJob job;
+        job.begin    = begin;
+        job.endLine  = end->line;
+        job.blockIdx = jobs.size();
+        jobs << job;
+        after = end->line;
+    }
+    return jobs;
+}
+
+void parseLightIntegration(IntegrationJob &job, LineRange &lines,
+                           const QRegularExpression &targetRe,
+                           const QString &filePath)
+{
+    auto &dbg = DebugLogger::instance();
+    dbg.logDecision(QStringLiteral("Block %1: lines %2–%3")
+                        .arg(job.blockIdx).arg(job.begin.line).arg(job.endLine));
+
+    IntegrationBlockParser parser(job.blockIdx, targetRe);
+    lines.forEach(job.begin, job.endLine,
+                  [&parser](QByteArrayView s, WbppMarkerHits hits, int) {
+                      parser.feed(s, hits);
+                  });
+
+    if (parser.isLnReference()) {
+        dbg.logDecision(
+            QStringLiteral("Block %1: skipped — produces LN_Reference_ "
+                           "master (Local Normalization integration)")
+                .arg(job.blockIdx));
+        return;
+    }
+
+    IntegrationGroup &grp = job.grp;
+    grp.sourceLogFile = filePath;
+    grp.sessionIndex  = job.blockIdx;
+    if (!parser.finish(grp)) {
+        dbg.logWarning(
+            QStringLiteral("Block %1 rejected (no .xisf paths found)")
+                .arg(job.blockIdx));
+        return;
+    }
+    dbg.logDecision(
+        QStringLiteral("Block %1 accepted: target='%2' filter='%3' "
+                       "exposure=%4s frames=%5")
+            .arg(job.blockIdx)
+            .arg(grp.logTarget.isEmpty()
+                     ? QStringLiteral("(none)") : grp.logTarget,
+                 grp.frames.isEmpty()
+                     ? QStringLiteral("(none)")
+                     : grp.frames.first().filter.isEmpty()
+                           ? QStringLiteral("(none)")
+                           : grp.frames.first().filter)
+            .arg(grp.exposureSec)
+            .arg(grp.frames.size()));
+    job.accepted = true;
+}
+
+// ── Light calibration ───────────────────────────────────────────────────
+
+struct LightCalJob {
+    WbppMarkerPos    begin;
+    WbppMarkerPos    end;
+    int              tailLast{0};  // last line of the summary tail
+    CalibrationBlock blk;
+};
+
+QList<LightCalJob> planLightCalibration(const WbppLogIndex &idx, bool growing)
+{
+    QList<LightCalJob> jobs;
+    int after = -1;
+    for (const WbppMarkerPos &begin : idx.markers(WbppLogIndex::LightCalBegin)) {
+        if (begin.line <= after) continue;
+
+        const WbppMarkerPos *end =
+            idx.nextAfter(WbppLogIndex::LightCalEnd, begin.line);
+        if (!end) {
+            if (!growing)
+                DebugLogger::instance().logWarning(
+                    QStringLiteral("No End marker found for Light cal block starting at line %1")
+                        .arg(begin.line));
+            break;
+        }
+
+        // The "Calibration frame N: … ---> …" summary follows the End
+        // marker and runs until the next Light calibration marker.
+        const WbppMarkerPos *nextBegin =
+            idx.nextAfter(WbppLogIndex::LightCalBegin, end->line);
+        const WbppMarkerPos *nextEnd =
+            idx.nextAfter(WbppLogIndex::LightCalEnd, end->line);
+
+        LightCalJob job;
+        job.begin    = begin;
+        job.end      = *end;
+        job.tailLast = std::min(nextBegin ? nextBegin->line : kToEof,
+                                nextEnd   ? nextEnd->line   : kToEof) - 1;
+
+        // In a growing log the summary is only known to be complete once
+        // WBPP has moved on to another block.
+        if (growing && !nextBegin && !nextEnd) {
+            const WbppMarkerPos *next = idx.nextAnyAfter(end->line);
+            if (!next) break;
+            job.tailLast = next->line - 1;
+        }
+        jobs << job;
+        after = end->line;
+    }
+    return jobs;
+}
+
+void parseLightCalibration(LightCalJob &job, LineRange &lines)
+{
+    static const QRegularExpression calFrameRe(
+        R"(Calibration frame \d+:\s*.+\s*--->\s*(.+\.xisf))");
+
+    auto &dbg = DebugLogger::instance();
+    dbg.logDecision(QStringLiteral("Light cal block: lines %1–%2")
+                        .arg(job.begin.line).arg(job.end.line));
+
+    LightCalibrationParser parser;
+    lines.forEach(job.begin, job.end.line,
+                  [&parser](QByteArrayView s, WbppMarkerHits hits, int) {
+                      parser.feed(s, hits);
+                  });
+    job.blk = parser.finish();
+
+    CalibrationBlock &blk     = job.blk;
+    const int         endLine = job.end.line;
+    lines.forEach(job.end, job.tailLast,
+                  [&blk, endLine](QByteArrayView s, WbppMarkerHits hits,
+                                  int lineNo) {
+                      if (lineNo == endLine
+                              || !hits.has(WbppMarker::CalibrationFrame))
+                          return;
+                      if (auto m = calFrameRe.match(decode(s)); m.hasMatch())
+                          blk.calibratedPaths << m.captured(1).trimmed();
+                  });
+
+    dbg.logResult(QStringLiteral("calibratedOutputPaths"),
+                  QString::number(blk.calibratedPaths.size()));
+    if (!blk.calibratedPaths.isEmpty())
+        dbg.logDecision(
+            QStringLiteral("Found %1 'Calibration frame N: … ---> …' entries after End marker")
+                .arg(blk.calibratedPaths.size()));
+    else
+        dbg.logDecision(
+            QStringLiteral("No 'Calibration frame N:' summary lines found after End marker"));
+}
+
+// ── Flat calibration + integration ──────────────────────────────────────
+
+struct FlatJob {
+    enum Integration { None, Unterminated, Found };
+
+    int           blockIdx{0};
+    WbppMarkerPos begin;
+    int           calEndLine{0};
+    Integration   integration{None};
+    WbppMarkerPos intBegin;
+    int           intLast{0};      // End marker line plus tail
+    bool          keep{false};
+    FlatBlock     blk;
+};
+
+QList<FlatJob> planFlatBlocks(const WbppLogIndex &idx, bool growing)
+{
+    // Lines after the integration End marker may still carry the output
+    // path ("Writing master Flat frame:" is sometimes logged afterwards).
+    constexpr int kFlatTailLines = 9;
+
+    QList<FlatJob> jobs;
+    int after = -1;
+    for (const WbppMarkerPos &begin : idx.markers(WbppLogIndex::FlatCalBegin)) {
+        if (begin.line <= after) continue;
+
+        const WbppMarkerPos *calEnd =
+            idx.nextAfter(WbppLogIndex::FlatCalEnd, begin.line);
+        if (!calEnd) {
+            if (!growing)
+                DebugLogger::instance().logWarning(
+                    QStringLiteral("Flat-cal block %1: no End marker found")
+                        .arg(jobs.size()));
+            break;
+        }
+
+        FlatJob job;
+        job.blockIdx   = jobs.size();
+        job.begin      = begin;
+        job.calEndLine = calEnd->line;
+        after          = calEnd->line;
+
+        // The matching integration block is the next Flat integration
+        // Begin, unless another Flat calibration block starts first.
+        const WbppMarkerPos *nextCal =
+            idx.nextAfter(WbppLogIndex::FlatCalBegin, calEnd->line);
+        const WbppMarkerPos *intBegin =
+            idx.nextAfter(WbppLogIndex::FlatIntegrationBegin, calEnd->line);
+        const WbppMarkerPos *intEnd = intBegin
+            ? idx.nextAfter(WbppLogIndex::FlatIntegrationEnd, intBegin->line)
+            : nullptr;
+
+        if (!intBegin || (nextCal && nextCal->line < intBegin->line)) {
+            if (growing && !nextCal) break;      // integration may follow
+            job.integration = FlatJob::None;
+        } else if (!intEnd) {
+            if (growing) break;
+            // No End marker anywhere after it: the block runs at most up
+            // to the next Flat calibration block, which is still parsed.
+            job.integration = FlatJob::Unterminated;
+            after           = intBegin->line;
+        } else {
+            // The tail stops early at the next Flat block marker.
+            int last = intEnd->line + kFlatTailLines;
+            for (WbppLogIndex::Kind k : { WbppLogIndex::FlatCalBegin,
+                                          WbppLogIndex::FlatIntegrationBegin })
+                if (const WbppMarkerPos *p = idx.nextAfter(k, intEnd->line))
+                    last = std::min(last, p->line - 1);
+            if (growing && last >= idx.lineCount()) break;  // tail incomplete
+
+            job.integration = FlatJob::Found;
+            job.intBegin    = *intBegin;
+            job.intLast     = last;
+            after           = last;
+        }
+        jobs << job;
+    }
+    return jobs;
+}
+
+void parseFlatBlock(FlatJob &job, LineRange &lines)
+{
+    auto &dbg = DebugLogger::instance();
+    dbg.logDecision(QStringLiteral("Flat-cal block %1: lines %2–%3")
+                        .arg(job.blockIdx).arg(job.begin.line).arg(job.calEndLine));
+
+    FlatCalibrationParser cal;
+    lines.forEach(job.begin, job.calEndLine,
+                  [&cal](QByteArrayView s, WbppMarkerHits hits, int) {
+                      cal.feed(s, hits);
+                  });
+    if (!cal.hasResult())
+        dbg.logDecision(QStringLiteral("Flat-cal bias: no path found in block"));
+    dbg.logResult(QStringLiteral("flatBlock[%1].masterBias").arg(job.blockIdx),
+                  cal.biasPath().isEmpty()
+                      ? QStringLiteral("(none)") : cal.biasPath());
+
+    FlatBlock &blk = job.blk;
+    blk.masterBiasPath = cal.biasPath();
+
+    switch (job.integration) {
+    case FlatJob::None:
+        dbg.logWarning(
+            QStringLiteral("Flat-cal block %1: no integration block follows")
+                .arg(job.blockIdx));
+        break;
+    case FlatJob::Unterminated:
+        dbg.logWarning(
+            QStringLiteral("Flat-cal block %1: integration End marker not found")
+                .arg(job.blockIdx));
+        break;
+    case FlatJob::Found: {
+        dbg.logDecision(
+            QStringLiteral("Flat-cal block %1: integration block starts at line %2")
+                .arg(job.blockIdx).arg(job.intBegin.line));
+        FlatIntegrationParser integ;
+        lines.forEach(job.intBegin, job.intLast,
+                      [&integ](QByteArrayView s, WbppMarkerHits hits, int) {
+                          integ.feed(s, hits);
+                      });
+        if (!integ.hasResult())
+            dbg.logDecision(
+                QStringLiteral("Flat integration master: no path found in block"));
+        blk.masterFlatPath = integ.masterFlatPath();
+        break;
+    }
+    }
+
+    dbg.logResult(QStringLiteral("flatBlock[%1].masterFlat").arg(job.blockIdx),
+                  blk.masterFlatPath.isEmpty()
+                      ? QStringLiteral("(none)") : blk.masterFlatPath);
+
+    job.keep = !blk.masterFlatPath.isEmpty() || !blk.masterBiasPath.isEmpty();
+    if (!job.keep)
+        dbg.logDecision(
+            QStringLiteral("Flat-cal block %1 discarded (both paths empty)")
+                .arg(job.blockIdx));
+}
+
+// Parses the blocks planned from idx, except the first `taken` of each
+// kind, and appends them to out.  Blocks are independent, so they are
+// parsed concurrently and reassembled in block order.  DebugLogger is not
+// thread-safe: stay on this thread while it records.
+void parseBlocks(LogFileReader &reader, const QString &filePath,
+                 const WbppLogIndex &idx, bool growing,
+                 WbppBlockCounts &taken, WbppScanResult &out)
+{
+    QList<IntegrationJob> integJobs = planLightIntegration(idx, growing);
+    QList<LightCalJob>    calJobs   = planLightCalibration(idx, growing);
+    QList<FlatJob>        flatJobs  = planFlatBlocks(idx, growing);
+
+    const int integTotal = integJobs.size();
+    const int calTotal   = calJobs.size();
+    const int flatTotal  = flatJobs.size();
+    integJobs.remove(0, qMin(taken.integration, integTotal));
+    calJobs.remove(0, qMin(taken.lightCal, calTotal));
+    flatJobs.remove(0, qMin(taken.flat, flatTotal));
+
+    const QRegularExpression targetRe = targetKeywordRe();
+    std::vector<BlockJob> jobs;
+    jobs.reserve(integJobs.size() + calJobs.size() + flatJobs.size());
+    for (IntegrationJob &job : integJobs)
+        jobs.push_back([&job, &targetRe, &filePath](LineRange &lines) {
+            parseLightIntegration(job, lines, targetRe, filePath);
+        });
+    for (LightCalJob &job : calJobs)
+        jobs.push_back([&job](LineRange &lines) {
+            parseLightCalibration(job, lines);
+        });
+    for (FlatJob &job : flatJobs)
+        jobs.push_back([&job](LineRange &lines) { parseFlatBlock(job, lines); });
+
+    runJobs(jobs, reader, filePath,
+            !DebugLogger::instance().isSessionActive());
+
+    for (const IntegrationJob &job : std::as_const(integJobs))
+        if (job.accepted) out.groups << job.grp;
+    for (const LightCalJob &job : std::as_const(calJobs))
+        out.calibrationBlocks << job.blk;
+    for (const FlatJob &job : std::as_const(flatJobs))
+        if (job.keep) out.flatBlocks << job.blk;
+
+    taken = WbppBlockCounts{ qMax(taken.integration, integTotal),
+                             qMax(taken.lightCal, calTotal),
+                             qMax(taken.flat, flatTotal) };
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+WbppScanResult WbppLogScanner::scan(const QString &filePath)
+{
+    m_error.clear();
+
+    const QFileInfo fi(filePath);
+    const QString   keywords =
+        AppSettings::instance().targetKeywords().join(QLatin1Char('\n'));
+
+    {
+        QMutexLocker lk(&g_cacheMutex);
+        auto it = g_cache.constFind(filePath);
+        if (it != g_cache.constEnd()
+                && it->size == fi.size()
+                && it->modified == fi.lastModified()
+                && it->targetKeywords == keywords) {
+            DebugLogger::instance().logDecision(
+                QStringLiteral("WbppLogScanner: reusing scan of %1")
+                    .arg(fi.fileName()));
+            return it->result;
+        }
+    }
+
+    WbppScanResult result;
+    if (auto saved = WbppScanDiskCache::load(filePath, fi, keywords)) {
+        DebugLogger::instance().logDecision(
+            QStringLiteral("WbppLogScanner: %1 loaded from parse cache")
+                .arg(fi.fileName()));
+        result = std::move(*saved);
+    } else {
+        result = scanFile(filePath, m_error);
+        if (!m_error.isEmpty()) return result;
+        WbppScanDiskCache::save(filePath, fi, keywords, result);
+    }
+
+    QMutexLocker lk(&g_cacheMutex);
+    g_cache.insert(filePath,
+                   CacheEntry{fi.size(), fi.lastModified(), keywords, result});
+    return result;
+}
+
+bool WbppLogScanner::hasSignature(const QString &filePath)
+{
+    LogFileReader reader(filePath);
+    if (!reader.open()) return false;
+    QByteArrayView line;
+    for (int i = 0; i < WbppLogIndex::kSignatureLines
+                    && reader.readLine(line); ++i)
+        if (WbppLogIndex::isSignatureLine(line)) return true;
+    return false;
+}
+
+void WbppLogScanner::forget(const QString &filePath)
+{
+    QMutexLocker lk(&g_cacheMutex);
+    g_cache.remove(filePath);
+}
+
+WbppScanResult WbppLogScanner::parseNewBlocks(const QString      &filePath,
+                                              const WbppLogIndex &index,
+                                              WbppBlockCounts    &taken,
+                                              bool                logComplete)
+{
+    WbppScanResult result;
+    result.isWbppLog  = index.isWbppLog();
+    result.totalLines = index.lineCount();
+
+    LogFileReader reader(filePath);
+    if (!reader.open()) return result;
+    parseBlocks(reader, filePath, index, !logComplete, taken, result);
+    return result;
+}
+
+WbppBlockCounts WbppLogScanner::blockCounts(const WbppLogIndex &index,
+                                            bool                logComplete)
+{
+    return WbppBlockCounts{
+        int(planLightIntegration(index, !logComplete).size()),
+        int(planLightCalibration(index, !logComplete).size()),
+        int(planFlatBlocks(index, !logComplete).size()) };
+}
+
+WbppScanResult WbppLogScanner::scanFile(const QString &filePath,
+                                        QString       &error)
+{
+    auto &dbg = DebugLogger::instance();
+    dbg.logSection(QStringLiteral("WbppLogScanner"));
+    dbg.logFileOpened(filePath);
+
+    WbppScanResult result;
+
+    LogFileReader reader(filePath);
+    if (!reader.open()) {
+        error = QStringLiteral("Cannot open file: ") + filePath;
+        dbg.logFileOpened(filePath, false);
+        dbg.logError(error);
+        return result;
+    }
+    dbg.logDecision(
+        QStringLiteral("Log size %1 bytes, %2")
+            .arg(reader.size())
+            .arg(reader.isMapped() ? QStringLiteral("memory-mapped")
+                                   : QStringLiteral("streamed in windows")));
+
+    // Pass 1: index every block marker.  Lines are byte views into the
+    // mapped file (or the current window); nothing is copied.
+    LogLineTokenizer tokenizer(reader);
+    result.index.scan(tokenizer);
+    result.isWbppLog  = result.index.isWbppLog();
+    result.totalLines = result.index.lineCount();
+
+    // Pass 2: parse each block from its indexed line range only.
+    WbppBlockCounts taken;
+    parseBlocks(reader, filePath, result.index, false, taken, result);
+
+    dbg.logResult(QStringLiteral("totalLines"),
+                  QString::number(result.totalLines));
+    dbg.logResult(QStringLiteral("groupsFound"),
+                  QString::number(result.groups.size()));
+    dbg.logResult(QStringLiteral("lightCalBlocksFound"),
+                  QString::number(result.calibrationBlocks.size()));
+    dbg.logResult(QStringLiteral("flatBlocksFound"),
+                  QString::number(result.flatBlocks.size()));
+    return result;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "models/integrationgroup.h"
+#include "calibrationlogparser.h"
+#include "wbpplogindex.h"
+#include <QString>
+#include <QList>
+
+// Everything AstrobinCSV extracts from one WBPP log file.
+struct WbppScanResult {
+    bool                     isWbppLog{false};  // PI/WBPP signature in the
+                                                // first lines of the file
+    int                      totalLines{0};
+    QList<IntegrationGroup>  groups;            // Light integration blocks
+                                                // (LN_Reference_ excluded)
+    QList<CalibrationBlock>  calibrationBlocks; // Light calibration blocks
+    QList<FlatBlock>         flatBlocks;        // Flat cal+integration pairs
+    WbppLogIndex             index;             // block marker positions
+};
+
+// Number of blocks of each kind already taken from a log that is still
+// being written (see WbppLogScanner::parseNewBlocks).
+struct WbppBlockCounts {
+    int integration{0};
+    int lightCal{0};
+    int flat{0};
+};
+
+// ── WbppLogScanner ────────────────────────────────────────────────────────
+//
+// Reads a WBPP log through LogFileReader (memory-mapped, so memory use does
+// not grow with the log).  One pass over the whole file builds a
+// WbppLogIndex of every Begin/End marker; the Light integration, Light
+// calibration and Flat calibration+integration parsers then re-read only
+// the line ranges of their own blocks, located through the index.  Blocks
+// are independent, so they are parsed concurrently on idle global thread
+// pool threads and reassembled in block order.
+//
+// PixInsightLogParser and CalibrationLogParser are thin views over the
+// scan result.  Results are cached in memory per log file and revalidated
+// against the file size and modification time, so the three entry points
+// used during one import (parse, parse, parseFlatBlocks) share
+// one read of the file.  They are also persisted by WbppScanDiskCache, so
+// re-adding an unchanged log in a later session does not read it at all.
+// ─────────────────────────────────────────────────────────────────────────
+class WbppLogScanner {
+public:
+    // Returns the scan of filePath, from the cache when the file has not
+    // changed.  On open failure returns an empty result and sets
+    // errorString().
+    WbppScanResult scan(const QString &filePath);
+
+    QString errorString() const { return m_error; }
+
+    // True if one of the first lines of filePath carries the PI/WBPP
+    // signature.  Reads only those lines, so it is cheap for any file.
+    static bool hasSignature(const QString &filePath);
+
+    // Drops the in-memory scan for filePath (called when a log is removed).
+    // The on-disk entry stays; it is revalidated if the log is re-added.
+    static void forget(const QString &filePath);
+
+    // For a log that is still being written: parses the blocks of index
+    // that are complete and cannot change as the log grows, skipping the
+    // ones already counted in taken, and advances taken past them.  With
+    // logComplete the log is treated as finished and every remaining block
+    // is parsed.  The result holds only the new blocks; index is not
+    // copied into it.
+    static WbppScanResult parseNewBlocks(const QString      &filePath,
+                                         const WbppLogIndex &index,
+                                         WbppBlockCounts    &taken,
+                                         bool                logComplete = false);
+
+    // The blocks of each kind parseNewBlocks would take from index, for
+    // seeding the counts of a log whose scan is already loaded.
+    static WbppBlockCounts blockCounts(const WbppLogIndex &index,
+                                       bool                logComplete = false);
+
+private:
+    QString m_error;
+
+    static WbppScanResult scanFile(const QString &filePath, QString &error);
+};
@@ -0,0 +1,117 @@
+#include "wbpplogtailer.h"
+#include "logfilereader.h"
+#include "loglinetokenizer.h"
+#include <QFile>
+#include <QFileInfo>
+
+WbppLogTailer::WbppLogTailer(const QString   &filePath,
+                             WbppBlockCounts  taken,
+                             QObject         *parent)
+    : QObject(parent), m_filePath(filePath), m_taken(taken)
+{
+    m_pollTimer.setInterval(kPollMs);
+    connect(&m_pollTimer, &QTimer::timeout, this, &WbppLogTailer::update);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged,
+            this, &WbppLogTailer::update);
+}
+
+void WbppLogTailer::start()
+{
+    if (m_running) return;
+    m_running = true;
+    m_watcher.addPath(m_filePath);
+    m_pollTimer.start();
+    update();
+}
+
+void WbppLogTailer::stop()
+{
+    if (!m_running) return;
+    m_running = false;
+    m_pollTimer.stop();
+    if (m_watcher.files().contains(m_filePath))
+        m_watcher.removePath(m_filePath);
+
+    // The log is finished: blocks still waiting for more output are
+    // parsed as they are.  A paused receiver is still busy with the last
+    // blocks, so they are not handed over before it resumes.
+    if (m_paused)
+        m_flushPending = true;
+    else
+        parse(false);
+}
+
+void WbppLogTailer::setPaused(bool paused)
+{
+    if (m_paused == paused) return;
+    m_paused = paused;
+    if (paused) return;
+    if (m_flushPending) {
+        m_flushPending = false;
+        QTimer::singleShot(0, this, [this]() { parse(false); });
+    } else if (m_running) {
+        QTimer::singleShot(0, this, &WbppLogTailer::update);
+    }
+}
+
+void WbppLogTailer::update()
+{
+    if (!m_running || m_paused) return;
+
+    // A file that was replaced drops out of the watcher; re-arm it.
+    if (!m_watcher.files().contains(m_filePath) && QFileInfo::exists(m_filePath))
+        m_watcher.addPath(m_filePath);
+    parse(true);
+}
+
+void WbppLogTailer::parse(bool growing)
+{
+    const qint64 size = QFileInfo(m_filePath).size();
+    if (size < m_index.indexedBytes()) {
+        // Truncated or rewritten: start over from the top.
+        m_index = WbppLogIndex();
+        m_taken = WbppBlockCounts();
+        emit logReset();
+    }
+
+    // While the log grows, a trailing line without its newline may still
+    // be half written; leave it for the next update.
+    const qint64 end = growing ? completeLinesEnd(size) : size;
+    if (end > m_index.indexedBytes()) {
+        LogFileReader reader(m_filePath);
+        if (!reader.open()) return;
+        LogLineTokenizer tokenizer(reader);
+        if (!tokenizer.seek(m_index.indexedBytes(), m_index.lineCount()))
+            return;
+        m_index.scan(tokenizer, end);
+    } else if (growing) {
+        return;     // nothing appended
+    }
+
+    const WbppScanResult r =
+        WbppLogScanner::parseNewBlocks(m_filePath, m_index, m_taken, !growing);
+    if (!r.calibrationBlocks.isEmpty() || !r.flatBlocks.isEmpty())
+        emit calibrationAppended(r.calibrationBlocks, r.flatBlocks);
+    if (!r.groups.isEmpty())
+        emit groupsAppended(r.groups);
+}
+
+qint64 WbppLogTailer::completeLinesEnd(qint64 fileSize) const
+{
+    constexpr qint64 kChunk = 64 * 1024;
+
+    const qint64 from = m_index.indexedBytes();
+    QFile f(m_filePath);
+    if (!f.open(QIODevice::ReadOnly)) return from;
+
+    // Search backwards for the last newline in the appended bytes.
+    for (qint64 hi = fileSize; hi > from; ) {
+        const qint64 lo = qMax(from, hi - kChunk);
+        if (!f.seek(lo)) break;
+        const QByteArray  buf = f.read(hi - lo);
+        const qsizetype   nl  = buf.lastIndexOf('\n');
+        if (nl >= 0) return lo + nl + 1;
+        hi = lo;
+    }
+    return from;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "wbpplogscanner.h"
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+// ── WbppLogTailer ─────────────────────────────────────────────────────────
+//
+// Follows a WBPP log that is still being written.  Whenever the file grows
+// only the appended complete lines are indexed (WbppLogIndex continues
+// where it stopped) and the blocks that became complete are parsed and
+// emitted; blocks whose End marker has not been written yet simply wait
+// for a later update instead of being dropped.
+//
+// QFileSystemWatcher is backed by a slow poll, because change
+// notifications are unreliable for files appended on network shares.
+// stop() treats the log as finished and emits whatever is still pending;
+// while paused, that final flush waits until the tailer is resumed.
+// ─────────────────────────────────────────────────────────────────────────
+class WbppLogTailer : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kPollMs = 5000;
+
+    // Blocks counted in `taken` were already loaded and are not emitted
+    // again.
+    explicit WbppLogTailer(const QString   &filePath,
+                           WbppBlockCounts  taken  = {},
+                           QObject         *parent = nullptr);
+
+    QString filePath() const { return m_filePath; }
+
+    void start();
+    void stop();
+
+    // While paused, appended output is left alone; it is picked up on the
+    // first update after resuming.
+    void setPaused(bool paused);
+
+signals:
+    void groupsAppended(const QList<IntegrationGroup> &groups);
+    void calibrationAppended(const QList<CalibrationBlock> &calibrationBlocks,
+                             const QList<FlatBlock>        &flatBlocks);
+    void logReset();    // the file was truncated or replaced
+
+private slots:
+    void update();
+
+private:
+    QString            m_filePath;
+    QFileSystemWatcher m_watcher;
+    QTimer             m_pollTimer;
+    WbppLogIndex       m_index;
+    WbppBlockCounts    m_taken;
+    bool               m_running{false};
+    bool               m_paused{false};
+    bool               m_flushPending{false};   // stopped while paused
+
+    void parse(bool growing);
+    qint64 completeLinesEnd(qint64 fileSize) const;
+};
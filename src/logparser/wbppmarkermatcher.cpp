@@ -0,0 +1,120 @@
+#include "wbppmarkermatcher.h"
+#include <iterator>
+
+namespace {
+
+struct Anchor {
+    WbppMarker  marker;
+    const char *text;
+};
+
+constexpr Anchor kAnchors[] = {
+    { WbppMarker::IntegrationBegin,     "* Begin integration of Light frames" },
+    { WbppMarker::FastIntegrationBegin, "* Begin fast integration of Light frames" },
+    { WbppMarker::IntegrationEnd,       "* End integration of Light frames" },
+    { WbppMarker::FastIntegrationEnd,   "* End fast integration of Light frames" },
+    { WbppMarker::WritingMasterLight,   "* Writing master Light frame:" },
+    { WbppMarker::Filter,               "Filter" },
+    { WbppMarker::Exposure,             "Exposure" },
+    { WbppMarker::Keywords,             "Keywords" },
+    { WbppMarker::ImagesArray,          "II.images" },
+    { WbppMarker::TargetsArray,         "FI.targets" },
+    { WbppMarker::Xisf,                 ".xisf" },
+
+    { WbppMarker::LightCalBegin,        "* Begin calibration of Light frames" },
+    { WbppMarker::LightCalEnd,          "* End calibration of Light frames" },
+    { WbppMarker::CalibrationFrame,     "Calibration frame " },
+    { WbppMarker::ICMaster,             "IC.master" },
+    { WbppMarker::ICMasterBiasPath,     "IC.masterBiasPath" },
+    { WbppMarker::MasterBias,           "Master bias:" },
+
+    { WbppMarker::FlatCalBegin,         "* Begin calibration of Flat frames" },
+    { WbppMarker::FlatCalEnd,           "* End calibration of Flat frames" },
+    { WbppMarker::FlatIntegrationBegin, "* Begin integration of Flat frames" },
+    { WbppMarker::FlatIntegrationEnd,   "* End integration of Flat frames" },
+    { WbppMarker::WritingMasterFlat,    "Writing master Flat frame" },
+    { WbppMarker::AddMasterFile,        "Add the master file:" },
+};
+
+static_assert(static_cast<int>(WbppMarker::Count) <= 64,
+              "WbppMarkerHits holds at most 64 markers");
+static_assert(std::size(kAnchors) == static_cast<size_t>(WbppMarker::Count),
+              "every WbppMarker needs exactly one anchor");
+
+constexpr qint32 kNone = -1;
+
+} // namespace
+
+const WbppMarkerMatcher &WbppMarkerMatcher::instance()
+{
+    static const WbppMarkerMatcher matcher;
+    return matcher;
+}
+
+WbppMarkerMatcher::WbppMarkerMatcher()
+{
+    for (const Anchor &a : kAnchors)
+        for (const char *c = a.text; *c; ++c) {
+            const uchar b = static_cast<uchar>(*c);
+            if (!m_classOf[b]) m_classOf[b] = static_cast<quint8>(m_classCount++);
+        }
+    const int k = m_classCount;
+
+    // Trie of all anchors.
+    m_next.assign(k, kNone);
+    m_out.assign(1, 0);
+    for (const Anchor &a : kAnchors) {
+        qint32 s = 0;
+        for (const char *c = a.text; *c; ++c) {
+            const int cls = m_classOf[static_cast<uchar>(*c)];
+            if (m_next[s * k + cls] == kNone) {
+                const qint32 t = static_cast<qint32>(m_out.size());
+                m_next[s * k + cls] = t;
+                m_next.resize(m_next.size() + k, kNone);
+                m_out.push_back(0);
+            }
+            s = m_next[s * k + cls];
+        }
+        m_out[s] |= WbppMarkerHits::bit(a.marker);
+    }
+
+    // Breadth-first pass: compute failure links and turn the trie into a
+    // complete DFA, so match() never has to follow a failure chain.
+    std::vector<qint32> fail(m_out.size(), 0);
+    std::vector<qint32> queue;
+    queue.reserve(m_out.size());
+    for (int c = 0; c < k; ++c) {
+        qint32 &t = m_next[c];
+        if (t == kNone) t = 0;
+        else            queue.push_back(t);
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const qint32 s = queue[head];
+        m_out[s] |= m_out[fail[s]];
+        for (int c = 0; c < k; ++c) {
+            qint32 &t = m_next[s * k + c];
+            const qint32 viaFail = m_next[fail[s] * k + c];
+            if (t == kNone) {
+                t = viaFail;
+            } else {
+                fail[t] = viaFail;
+                queue.push_back(t);
+            }
+        }
+    }
+}
+
+WbppMarkerHits WbppMarkerMatcher::match(QByteArrayView line) const
+{
+    WbppMarkerHits hits;
+    const int      k     = m_classCount;
+    const qint32  *next  = m_next.data();
+    const quint64 *out   = m_out.data();
+    qint32         state = 0;
+
+    for (const char ch : line) {
+        state = next[state * k + m_classOf[static_cast<uchar>(ch)]];
+        hits.m_bits |= out[state];
+    }
+    return hits;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <QByteArrayView>
+#include <QtGlobal>
+#include <array>
+#include <vector>
+
+// Literal anchors the WBPP block parsers react to.  A field regex is only
+// run on a line whose anchor was found.
+enum class WbppMarker : int {
+    // Light integration
+    IntegrationBegin,           // "* Begin integration of Light frames"
+    FastIntegrationBegin,       // "* Begin fast integration of Light frames"
+    IntegrationEnd,
+    FastIntegrationEnd,
+    WritingMasterLight,         // "* Writing master Light frame:"
+    Filter,
+    Exposure,
+    Keywords,
+    ImagesArray,                // "II.images"
+    TargetsArray,               // "FI.targets"
+    Xisf,                       // ".xisf"
+
+    // Light calibration
+    LightCalBegin,
+    LightCalEnd,
+    CalibrationFrame,           // "Calibration frame "
+    ICMaster,                   // "IC.master"
+    ICMasterBiasPath,           // "IC.masterBiasPath"
+    MasterBias,                 // "Master bias:"
+
+    // Flat calibration + integration
+    FlatCalBegin,
+    FlatCalEnd,
+    FlatIntegrationBegin,
+    FlatIntegrationEnd,
+    WritingMasterFlat,          // "Writing master Flat frame"
+    AddMasterFile,              // "Add the master file:"
+
+    Count
+};
+
+// Set of markers found on one line.
+class WbppMarkerHits {
+public:
+    bool has(WbppMarker m) const { return m_bits & bit(m); }
+    bool isEmpty() const { return m_bits == 0; }
+
+private:
+    friend class WbppMarkerMatcher;
+    static constexpr quint64 bit(WbppMarker m)
+    {
+        return quint64(1) << static_cast<int>(m);
+    }
+    quint64 m_bits{0};
+};
+
+// ── WbppMarkerMatcher ─────────────────────────────────────────────────────
+//
+// Aho-Corasick automaton over every WbppMarker anchor.  One left-to-right
+// pass over a line's bytes reports all anchors it contains (overlapping
+// ones included), replacing a chain of per-pattern searches.
+//
+// The automaton is built once and is immutable afterwards, so instance()
+// may be used from any thread.
+// ─────────────────────────────────────────────────────────────────────────
+class WbppMarkerMatcher {
+public:
+    static const WbppMarkerMatcher &instance();
+
+    WbppMarkerHits match(QByteArrayView line) const;
+
+private:
+    WbppMarkerMatcher();
+
+    // Bytes that occur in no anchor share class 0, which keeps the
+    // transition table small enough to stay in L1/L2.
+    std::array<quint8, 256> m_classOf{};
+    int                     m_classCount{1};
+    std::vector<qint32>     m_next;    // state * m_classCount + class
+    std::vector<quint64>    m_out;     // markers ending in each state
+};
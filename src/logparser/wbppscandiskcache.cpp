@@ -0,0 +1,193 @@
+#include "wbppscandiskcache.h"
+#include "debuglogger.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+static constexpr quint32 kMagic   = 0x41425343;   // "ABSC"
+static constexpr quint32 kVersion = 1;
+
+// Stream operators live at global scope so QList's operators find them by
+// argument-dependent lookup.  Only the log-derived fields are stored;
+// everything else is filled in later by FrameResolveWorker.
+static QDataStream &operator<<(QDataStream &out, const AcquisitionFrame &f)
+{
+    return out << f.registeredPath << f.exposureSec << f.logTarget
+               << f.targetFromLog << f.filter;
+}
+
+static QDataStream &operator>>(QDataStream &in, AcquisitionFrame &f)
+{
+    return in >> f.registeredPath >> f.exposureSec >> f.logTarget
+              >> f.targetFromLog >> f.filter;
+}
+
+static QDataStream &operator<<(QDataStream &out, const IntegrationGroup &g)
+{
+    return out << g.sourceLogFile << qint32(g.sessionIndex) << g.exposureSec
+               << g.logTarget << g.targetFromLog << g.frames;
+}
+
+static QDataStream &operator>>(QDataStream &in, IntegrationGroup &g)
+{
+    qint32 sessionIndex = -1;
+    in >> g.sourceLogFile >> sessionIndex >> g.exposureSec
+       >> g.logTarget >> g.targetFromLog >> g.frames;
+    g.sessionIndex = sessionIndex;
+    return in;
+}
+
+static QDataStream &operator<<(QDataStream &out, const CalibrationBlock &b)
+{
+    return out << b.masterDarkPath << b.masterFlatPath << b.masterBiasPath
+               << b.calibratedPaths;
+}
+
+static QDataStream &operator>>(QDataStream &in, CalibrationBlock &b)
+{
+    return in >> b.masterDarkPath >> b.masterFlatPath >> b.masterBiasPath
+              >> b.calibratedPaths;
+}
+
+static QDataStream &operator<<(QDataStream &out, const FlatBlock &b)
+{
+    return out << b.masterFlatPath << b.masterBiasPath;
+}
+
+static QDataStream &operator>>(QDataStream &in, FlatBlock &b)
+{
+    return in >> b.masterFlatPath >> b.masterBiasPath;
+}
+
+// Marks a cache file as just used for prune().  Changing a file time
+// needs a handle opened for writing (on Windows, write-attribute access).
+// Where that is refused, the entry is written again instead.
+static bool touch(const QString &cacheFile)
+{
+    {
+        QFile f(cacheFile);
+        if (f.open(QIODevice::ReadWrite)
+                && f.setFileTime(QDateTime::currentDateTime(),
+                                 QFileDevice::FileModificationTime))
+            return true;
+    }
+
+    QFile in(cacheFile);
+    if (!in.open(QIODevice::ReadOnly)) return false;
+    const QByteArray data = in.readAll();
+    in.close();
+    QSaveFile out(cacheFile);
+    return out.open(QIODevice::WriteOnly)
+        && out.write(data) == data.size()
+        && out.commit();
+}
+
+QString WbppScanDiskCache::cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+           + QStringLiteral("/parsecache");
+}
+
+QString WbppScanDiskCache::cacheFilePath(const QString &filePath)
+{
+    const QByteArray key = QCryptographicHash::hash(
+        QFileInfo(filePath).absoluteFilePath().toUtf8(),
+        QCryptographicHash::Sha1).toHex();
+    return cacheDirectory() + QLatin1Char('/') + QString::fromLatin1(key)
+           + QStringLiteral(".scan");
+}
+
+QByteArray WbppScanDiskCache::contentHash(const QString &filePath, qint64 size)
+{
+    QFile f(filePath);
+    if (!f.open(QIODevice::ReadOnly)) return {};
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(f.read(kHashBytes));
+    if (size > kHashBytes) {
+        if (!f.seek(qMax(kHashBytes, size - kHashBytes))) return {};
+        hash.addData(f.read(kHashBytes));
+    }
+    return hash.result();
+}
+
+std::optional<WbppScanResult> WbppScanDiskCache::load(const QString   &filePath,
+                                                      const QFileInfo &fileInfo,
+                                                      const QString   &targetKeywords)
+{
+    QFile f(cacheFilePath(filePath));
+    if (!f.open(QIODevice::ReadOnly)) return std::nullopt;
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32    magic = 0, version = 0;
+    QString    path, keywords;
+    qint64     size = -1, mtime = -1;
+    QByteArray hash;
+    in >> magic >> version;
+    if (magic != kMagic || version != kVersion) return std::nullopt;
+    in >> path >> size >> mtime >> keywords >> hash;
+    if (in.status() != QDataStream::Ok
+            || path != filePath
+            || size != fileInfo.size()
+            || mtime != fileInfo.lastModified().toMSecsSinceEpoch()
+            || keywords != targetKeywords
+            || hash.isEmpty()
+            || hash != contentHash(filePath, size))
+        return std::nullopt;
+
+    WbppScanResult r;
+    qint32 totalLines = 0;
+    in >> r.isWbppLog >> totalLines >> r.groups >> r.calibrationBlocks
+       >> r.flatBlocks >> r.index;
+    if (in.status() != QDataStream::Ok) return std::nullopt;
+    r.totalLines = totalLines;
+
+    // Keeps the entry off the pruning list.
+    f.close();
+    if (!touch(f.fileName()))
+        DebugLogger::instance().logWarning(
+            QStringLiteral("Parse cache entry %1 could not be marked as "
+                           "used; it may be pruned early").arg(f.fileName()));
+    return r;
+}
+
+void WbppScanDiskCache::save(const QString        &filePath,
+                             const QFileInfo      &fileInfo,
+                             const QString        &targetKeywords,
+                             const WbppScanResult &result)
+{
+    const QByteArray hash = contentHash(filePath, fileInfo.size());
+    if (hash.isEmpty()) return;
+    if (!QDir().mkpath(cacheDirectory())) return;
+
+    QSaveFile f(cacheFilePath(filePath));
+    if (!f.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kMagic << kVersion
+        << filePath << fileInfo.size()
+        << fileInfo.lastModified().toMSecsSinceEpoch()
+        << targetKeywords << hash
+        << result.isWbppLog << qint32(result.totalLines)
+        << result.groups << result.calibrationBlocks << result.flatBlocks
+        << result.index;
+    if (out.status() == QDataStream::Ok && f.commit())
+        prune();
+}
+
+void WbppScanDiskCache::prune()
+{
+    QDir dir(cacheDirectory());
+    const QFileInfoList entries =
+        dir.entryInfoList({ QStringLiteral("*.scan") }, QDir::Files,
+                          QDir::Time);      // most recently used first
+    for (qsizetype i = kMaxEntries; i < entries.size(); ++i)
+        QFile::remove(entries.at(i).absoluteFilePath());
+}
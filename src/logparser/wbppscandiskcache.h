@@ -0,0 +1,47 @@
+#pragma once
+#include "wbpplogscanner.h"
+#include <QFileInfo>
+#include <QString>
+#include <optional>
+
+// ── WbppScanDiskCache ─────────────────────────────────────────────────────
+//
+// Keeps WbppLogScanner results across sessions: one small binary file per
+// log under AppLocalDataLocation/parsecache, named after a hash of the
+// log's absolute path.
+//
+// An entry is valid while the log's size and modification time match and
+// the hash of its first and last kHashBytes is unchanged, so validating
+// costs a stat and two small reads however large the log is.  The target
+// keyword setting is part of the key because target extraction depends on
+// it.  Only the fields WbppLogScanner fills are stored.
+//
+// A hit marks its entry as used by touching the file.  When an entry is
+// saved and the directory holds more than kMaxEntries, the entries used
+// least recently are removed.
+// ─────────────────────────────────────────────────────────────────────────
+class WbppScanDiskCache {
+public:
+    static constexpr qint64 kHashBytes = 4 * 1024;
+    static constexpr int    kMaxEntries = 500;
+
+    // Returns the cached scan of filePath, or nullopt when there is no
+    // valid entry.  fileInfo is the caller's stat of the log.
+    static std::optional<WbppScanResult> load(const QString   &filePath,
+                                              const QFileInfo &fileInfo,
+                                              const QString   &targetKeywords);
+
+    // Stores result for filePath.  fileInfo must be the stat taken before
+    // the log was scanned.  Failures are silently ignored.
+    static void save(const QString        &filePath,
+                     const QFileInfo      &fileInfo,
+                     const QString        &targetKeywords,
+                     const WbppScanResult &result);
+
+    static QString cacheDirectory();
+
+private:
+    static QString    cacheFilePath(const QString &filePath);
+    static QByteArray contentHash(const QString &filePath, qint64 size);
+    static void       prune();
+};
@@ -0,0 +1,62 @@
+#include "logparseworker.h"
+#include "logparser/pixinsightlogparser.h"
+#include "logparser/sirillogparser.h"
+#include "debuglogger.h"
+#include <QThread>
+#include <QThreadPool>
+
+void LogParseWorker::run()
+{
+    auto &dbg = DebugLogger::instance();
+
+    const int total = paths.size();
+    results.clear();
+    results.resize(total);
+    QAtomicInt done{0};
+
+    // DebugLogger is not thread-safe: parse serially while it records.
+    QThreadPool pool;
+    pool.setMaxThreadCount(dbg.isSessionActive()
+                               ? 1 : QThread::idealThreadCount());
+
+    // Each task writes only its own slot; the list is not resized while
+    // the pool runs.
+    LogParseResult *out = results.data();
+    for (int i = 0; i < total; ++i) {
+        out[i].path = paths.at(i);
+        pool.start([this, out, i, total, &done]() {
+            if (cancelFlag->loadAcquire()) {
+                emit progress(done.fetchAndAddOrdered(1) + 1, total);
+                return;
+            }
+            out[i] = parseOne(paths.at(i));
+            emit progress(done.fetchAndAddOrdered(1) + 1, total);
+        });
+    }
+    pool.waitForDone();
+
+    emit finished();
+}
+
+LogParseResult LogParseWorker::parseOne(const QString &path)
+{
+    LogParseResult r;
+    r.path = path;
+
+    PixInsightLogParser piParser;
+    SirilLogParser      sirilParser;
+    if (piParser.canParse(path)) {
+        r.groups = piParser.parse(path);
+        r.status = r.groups.isEmpty() ? LogParseResult::NoGroups
+                                      : LogParseResult::Parsed;
+        r.error  = piParser.errorString();
+    } else if (sirilParser.canParse(path)) {
+        r.groups = sirilParser.parse(path);
+        r.status = r.groups.isEmpty() ? LogParseResult::NoGroups
+                                      : LogParseResult::Parsed;
+        r.error  = sirilParser.errorString();
+    } else {
+        r.status = LogParseResult::UnknownFormat;
+    }
+    return r;
+}
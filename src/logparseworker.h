@@ -0,0 +1,53 @@
+#pragma once
+#include <QObject>
+#include <QAtomicInt>
+#include <QList>
+#include <QStringList>
+#include "models/integrationgroup.h"
+
+// Outcome of parsing one log file selected in Add Log.
+struct LogParseResult {
+    enum Status {
+        Parsed,           // groups is non-empty
+        NoGroups,         // WBPP / Siril log without usable groups
+        UnknownFormat,
+        Cancelled         // never started because cancel was requested
+    };
+
+    QString                 path;
+    Status                  status{Cancelled};
+    QList<IntegrationGroup> groups;
+    QString                 error;
+};
+
+// ── LogParseWorker ────────────────────────────────────────────────────────
+//
+// Runs on a background thread and parses the logs selected in Add Log, one
+// thread-pool task per log, so a batch loads concurrently and the window
+// stays responsive.  results[i] always belongs to paths[i], whatever order
+// the tasks finish in, so groups merge back in file order.
+//
+// Logs not yet started when cancelFlag is raised are reported as
+// Cancelled.  While a debug session is active the logs are parsed one at a
+// time so the debug log is not interleaved.
+// ─────────────────────────────────────────────────────────────────────────
+class LogParseWorker : public QObject {
+    Q_OBJECT
+public:
+    // Set by MainWindow before starting the thread.
+    QStringList            paths;
+    QAtomicInt            *cancelFlag{nullptr};
+
+    // Filled by run(), same order as paths.
+    QList<LogParseResult>  results;
+
+signals:
+    void progress(int logsParsed, int logsTotal);
+    void finished();
+
+public slots:
+    void run();
+
+private:
+    static LogParseResult parseOne(const QString &path);
+};
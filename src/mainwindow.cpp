@@ -1,10 +1,13 @@
 #include "mainwindow.h"
 #include "models/csvtablemodel.h"
-#include "logparser/pixinsightlogparser.h"
-#include "logparser/sirillogparser.h"
 #include "logparser/logparserbase.h"
+#include "logparser/wbpplogscanner.h"
+#include "logparser/wbpplogtailer.h"
 #include "xisfheaderreader.h"
 #include "frameresolverworker.h"
+#include "headermetadatacache.h"
+#include "pagecachehints.h"
+#include "logparseworker.h"
 #include "settings/appsettings.h"
 #include "dialogs/managelocations.h"
 #include "dialogs/managefilters.h"
@@ -41,7 +44,9 @@
 #include <QSplitter>
 #include <QPainter>
 #include <QEventLoop>
+#include <QScopeGuard>
 #include <cmath>
+#include <limits>
 
 // ── Styled splitter handle ────────────────────────────────────────────────
 class GripHandle : public QSplitterHandle {
@@ -115,6 +120,8 @@ MainWindow::MainWindow(QWidget *parent)
     buildCentralWidget();
     m_currentTheme = AppSettings::instance().theme();
     applyTheme(m_currentTheme);
+    PageCacheHints::setEnabled(AppSettings::instance().pageCacheHints());
+    PageCacheHints::setDropAfterRead(AppSettings::instance().dropHeaderPages());
     m_groupingCombo->setCurrentIndex(AppSettings::instance().groupingStrategy());
 
     m_baseFontSize = QApplication::font().pointSize();
@@ -168,6 +175,36 @@ void MainWindow::buildMenu()
 
     toolsMenu->addSeparator();
 
+    m_followLogAction = new QAction(tr("F&ollow Selected Log While Written"), this);
+    m_followLogAction->setCheckable(true);
+    m_followLogAction->setChecked(false);
+    connect(m_followLogAction, &QAction::triggered,
+            this, &MainWindow::onToggleFollowLog);
+    toolsMenu->addAction(m_followLogAction);
+
+    // Page cache use of frame header reads (see PageCacheHints).
+    auto *headerMenu = toolsMenu->addMenu(tr("Frame &Header Reads"));
+
+    auto *hintsAct = new QAction(tr("Limit &Readahead"), this);
+    hintsAct->setCheckable(true);
+    hintsAct->setChecked(AppSettings::instance().pageCacheHints());
+    connect(hintsAct, &QAction::toggled, this, [](bool on) {
+        PageCacheHints::setEnabled(on);
+        AppSettings::instance().setPageCacheHints(on);
+    });
+    headerMenu->addAction(hintsAct);
+
+    auto *dropAct = new QAction(tr("&Drop Header Pages After Reading"), this);
+    dropAct->setCheckable(true);
+    dropAct->setChecked(AppSettings::instance().dropHeaderPages());
+    connect(dropAct, &QAction::toggled, this, [](bool on) {
+        PageCacheHints::setDropAfterRead(on);
+        AppSettings::instance().setDropHeaderPages(on);
+    });
+    headerMenu->addAction(dropAct);
+
+    toolsMenu->addSeparator();
+
     m_themeAction = new QAction(tr("Switch to Dark Theme"), this);
     connect(m_themeAction, &QAction::triggered, this, &MainWindow::onToggleTheme);
     toolsMenu->addAction(m_themeAction);
@@ -388,6 +425,121 @@ void MainWindow::onToggleDebugLogging()
            : tr("Debug logging disabled"), 4000);
 }
 
+void MainWindow::onToggleFollowLog()
+{
+    if (!m_followLogAction->isChecked()) {
+        stopFollowingLog(true);
+        return;
+    }
+
+    const auto selected = m_logFileList->selectedItems();
+    const QString path = selected.size() == 1
+        ? selected.first()->data(Qt::UserRole).toString() : QString();
+    const WbppScanResult scan =
+        path.isEmpty() ? WbppScanResult() : WbppLogScanner().scan(path);
+    if (!scan.isWbppLog) {
+        QMessageBox::information(
+            this, tr("Follow Log"),
+            tr("Select one loaded PixInsight WBPP log to follow."));
+        m_followLogAction->setChecked(false);
+        return;
+    }
+
+    // Integration blocks up to the last one already loaded are in the
+    // table.  Of the calibration blocks, only those already complete are
+    // known now; scan() parsed the unfinished ones as if the log had
+    // ended, so they are left for the tailer to report once they close.
+    WbppBlockCounts taken = WbppLogScanner::blockCounts(scan.index, false);
+    taken.integration = 0;
+    for (const auto &g : std::as_const(m_groups))
+        if (g.sourceLogFile == path)
+            taken.integration = qMax(taken.integration, g.sessionIndex + 1);
+
+    WbppBlockCounts complete;
+    complete.integration = std::numeric_limits<int>::max();  // not needed
+    const WbppScanResult calibration =
+        WbppLogScanner::parseNewBlocks(path, scan.index, complete, false);
+    m_tailCalBlocks  = calibration.calibrationBlocks;
+    m_tailFlatBlocks = calibration.flatBlocks;
+
+    m_tailer = new WbppLogTailer(path, taken, this);
+
+    connect(m_tailer, &WbppLogTailer::groupsAppended,
+            this, [this, path](const QList<IntegrationGroup> &groups) {
+                // Stopping the tailer now would flush more groups into
+                // this handler while resolveFrames is still running.
+                const bool followEnabled = m_followLogAction->isEnabled();
+                m_followLogAction->setEnabled(false);
+                if (m_tailer) m_tailer->setPaused(true);
+                const auto resumeTail = qScopeGuard([this, followEnabled]() {
+                    m_followLogAction->setEnabled(followEnabled);
+                    if (m_tailer) m_tailer->setPaused(false);
+                });
+
+                QList<IntegrationGroup> newGroups = groups;
+                QStringList allLogPaths;
+                for (int i = 0; i < m_logFileList->count(); ++i)
+                    allLogPaths << m_logFileList->item(i)->data(Qt::UserRole).toString();
+                resolveFrames(newGroups, allLogPaths);
+
+                m_groups << newGroups;
+                rebuildRows();
+                updateStatusBar();
+                statusBar()->showMessage(
+                    tr("%n new integration group(s) in %1", nullptr,
+                       newGroups.size()).arg(QFileInfo(path).fileName()),
+                    4000);
+            });
+
+    connect(m_tailer, &WbppLogTailer::calibrationAppended,
+            this, [this, path](const QList<CalibrationBlock> &calBlocks,
+                               const QList<FlatBlock>        &flatBlocks) {
+                m_tailCalBlocks  << calBlocks;
+                m_tailFlatBlocks << flatBlocks;
+                statusBar()->showMessage(
+                    tr("%1: %2 Light and %3 Flat calibration block(s) complete")
+                        .arg(QFileInfo(path).fileName())
+                        .arg(calBlocks.size())
+                        .arg(flatBlocks.size()),
+                    4000);
+            });
+
+    // The log was truncated or replaced: its groups are re-reported from
+    // the top.
+    connect(m_tailer, &WbppLogTailer::logReset, this, [this, path]() {
+        WbppLogScanner::forget(path);
+        m_tailCalBlocks.clear();
+        m_tailFlatBlocks.clear();
+        m_groups.erase(
+            std::remove_if(m_groups.begin(), m_groups.end(),
+                           [&](const IntegrationGroup &g) {
+                               return g.sourceLogFile == path;
+                           }),
+            m_groups.end());
+        rebuildRows();
+        updateStatusBar();
+    });
+
+    m_tailer->start();
+    statusBar()->showMessage(
+        tr("Following %1").arg(QFileInfo(path).fileName()), 4000);
+}
+
+void MainWindow::stopFollowingLog(bool flush)
+{
+    if (!m_tailer) return;
+    WbppLogTailer *tailer = m_tailer;
+    if (flush) {
+        // Emits the blocks that were still waiting for more output.
+        tailer->stop();
+    }
+    m_tailer = nullptr;
+    m_tailCalBlocks.clear();
+    m_tailFlatBlocks.clear();
+    tailer->deleteLater();
+    m_followLogAction->setChecked(false);
+}
+
 void MainWindow::onAddLog()
 {
     QString dir = AppSettings::instance().lastOpenDirectory();
@@ -404,6 +556,16 @@ void MainWindow::onAddLog()
     AppSettings::instance().setLastOpenDirectory(
         QFileInfo(files.first()).absolutePath());
 
+    // Keep a followed log from resolving frames in the middle of this
+    // import, and from being stopped, which would flush it regardless.
+    const bool followEnabled = m_followLogAction->isEnabled();
+    m_followLogAction->setEnabled(false);
+    if (m_tailer) m_tailer->setPaused(true);
+    const auto resumeTail = qScopeGuard([this, followEnabled]() {
+        m_followLogAction->setEnabled(followEnabled);
+        if (m_tailer) m_tailer->setPaused(false);
+    });
+
     QSet<QString> loadedPaths;
     for (int i = 0; i < m_logFileList->count(); ++i)
         loadedPaths.insert(
@@ -416,35 +578,83 @@ void MainWindow::onAddLog()
     // doesn't suppress prompts in this session.
     m_masterCache.skipPrompts = false;
 
-    PixInsightLogParser piParser;
-    SirilLogParser      sirilParser;
-    QList<IntegrationGroup> newGroups;
+    QStringList toParse;
+    for (const QString &path : files)
+        if (!loadedPaths.contains(path) && !toParse.contains(path))
+            toParse << path;
+    if (toParse.isEmpty()) {
+        if (dbg.isSessionActive()) dbg.endSession();
+        return;
+    }
 
-    for (const QString &path : files) {
-        if (loadedPaths.contains(path)) continue;
-
-        // Determine parser.
-        QList<IntegrationGroup> parsed;
-        if (piParser.canParse(path)) {
-            parsed = piParser.parse(path);
-            if (parsed.isEmpty()) {
-                if (dbg.isSessionActive())
-                    dbg.logError(
-                        QStringLiteral("No groups in %1: %2")
-                            .arg(path, piParser.errorString()));
-                QMessageBox::warning(
-                    this, tr("Parse Error"),
-                    tr("No integration groups found in:\n%1\n\n%2")
-                        .arg(path, piParser.errorString()));
-                continue;
-            }
-        } else if (sirilParser.canParse(path)) {
-            // Siril not yet implemented.
+    // Parse all selected logs on a worker pool; results come back in
+    // file order.
+    m_cancelRequested.storeRelease(0);
+    m_progressBar->setRange(0, toParse.size());
+    m_progressBar->setValue(0);
+    m_progressBar->setVisible(true);
+    m_cancelBtn->setVisible(true);
+    m_statusLabel->setText(tr("Parsing log files…"));
+
+    auto *thread = new QThread(this);
+    auto *worker = new LogParseWorker;
+    worker->paths      = toParse;
+    worker->cancelFlag = &m_cancelRequested;
+    worker->moveToThread(thread);
+
+    connect(thread, &QThread::started, worker, &LogParseWorker::run);
+    connect(worker, &LogParseWorker::progress,
+            this, [this](int done, int total) {
+                m_progressBar->setValue(done);
+                Q_UNUSED(total)
+            }, Qt::QueuedConnection);
+
+    QEventLoop loop;
+    connect(worker, &LogParseWorker::finished,
+            &loop, &QEventLoop::quit);
+
+    thread->start();
+    loop.exec();
+    thread->quit();
+    thread->wait();
+
+    const QList<LogParseResult> results = worker->results;
+    delete worker;
+    delete thread;
+
+    m_progressBar->setVisible(false);
+    m_cancelBtn->setVisible(false);
+    const bool cancelled = m_cancelRequested.loadAcquire();
+    m_cancelRequested.storeRelease(0);
+
+    if (cancelled) {
+        if (dbg.isSessionActive()) {
+            dbg.logDecision(QStringLiteral("Log import cancelled by user"));
+            dbg.endSession();
+        }
+        updateStatusBar();
+        return;
+    }
+
+    QList<IntegrationGroup> newGroups;
+    for (const LogParseResult &r : results) {
+        const QString &path = r.path;
+        switch (r.status) {
+        case LogParseResult::Parsed:
+            break;
+        case LogParseResult::NoGroups:
+            if (dbg.isSessionActive())
+                dbg.logError(
+                    QStringLiteral("No groups in %1: %2")
+                        .arg(path, r.error));
             QMessageBox::warning(
                 this, tr("Parse Error"),
-                tr("Siril log parsing is not yet implemented."));
+                tr("No integration groups found in:\n%1\n\n%2")
+                    .arg(path, r.error));
+            continue;
+        case LogParseResult::Cancelled:
             continue;
-        } else {
+        case LogParseResult::UnknownFormat:
             if (dbg.isSessionActive())
                 dbg.logWarning(
                     QStringLiteral("Unknown log format: %1").arg(path));
@@ -458,7 +668,7 @@ void MainWindow::onAddLog()
         item->setData(Qt::UserRole, path);
         item->setToolTip(path);
         m_logFileList->addItem(item);
-        newGroups << parsed;
+        newGroups << r.groups;
     }
 
     if (newGroups.isEmpty()) {
@@ -491,9 +701,13 @@ void MainWindow::onRemoveLog()
 
     QSet<QString> removedPaths;
     for (auto *item : selected) {
-        removedPaths.insert(item->data(Qt::UserRole).toString());
+        const QString path = item->data(Qt::UserRole).toString();
+        removedPaths.insert(path);
+        WbppLogScanner::forget(path);
         delete item;
     }
+    if (m_tailer && removedPaths.contains(m_tailer->filePath()))
+        stopFollowingLog(false);
 
     m_groups.erase(
         std::remove_if(m_groups.begin(), m_groups.end(),
@@ -506,6 +720,7 @@ void MainWindow::onRemoveLog()
     m_calConflictWarnedKeys.clear();
     m_masterCache.primaryDirs.clear();
     m_masterCache.secondaryDirs.clear();
+    m_masterCache.missing.clear();
 
     rebuildRows();
     updateStatusBar();
@@ -721,15 +936,20 @@ void MainWindow::resolveFrames(QList<IntegrationGroup> &newGroups,
 {
     auto &dbg = DebugLogger::instance();
 
-    // Build calibration lookup structures from all loaded log files.
+    // Build calibration lookup structures from all loaded log files.  A
+    // followed log changes on every update; its blocks come from the
+    // tailer instead of a rescan.
+    const QString tailPath = m_tailer ? m_tailer->filePath() : QString();
     CalibrationLogParser calParser;
     QList<CalibrationBlock> allBlocks;
     for (const QString &lf : allLogFiles)
-        allBlocks << calParser.parse(lf);
+        allBlocks << (lf == tailPath ? m_tailCalBlocks : calParser.parse(lf));
 
     QHash<QString, QString> flatToBias;
     for (const QString &lf : allLogFiles) {
-        for (const FlatBlock &fb : calParser.parseFlatBlocks(lf)) {
+        const QList<FlatBlock> flatBlocks =
+            lf == tailPath ? m_tailFlatBlocks : calParser.parseFlatBlocks(lf);
+        for (const FlatBlock &fb : flatBlocks) {
             if (!fb.masterFlatPath.isEmpty() && !fb.masterBiasPath.isEmpty())
                 flatToBias.insert(fb.masterFlatPath.toLower(),
                                   fb.masterBiasPath);
@@ -788,13 +1008,19 @@ void MainWindow::resolveFrames(QList<IntegrationGroup> &newGroups,
     m_progressBar->setValue(0);
     m_progressBar->setVisible(true);
     m_cancelBtn->setVisible(true);
-    m_statusLabel->setText(tr("Reading .xisf headers…"));
+    m_statusLabel->setText(tr("Reading frame headers…"));
+
+    // Trees searched during the last import may have changed since.
+    m_dirIndex.clear();
+    m_masterCache.missing.clear();
 
     auto *thread = new QThread(this);
     auto *worker = new FrameResolveWorker;
     worker->groups              = &newGroups;
     worker->cancelFlag          = &m_cancelRequested;
     worker->masterCache         = &m_masterCache;
+    worker->dirIndex            = &m_dirIndex;
+    worker->ioConcurrency       = AppSettings::instance().headerIoThreads();
     worker->basenameToBlock     = basenameToBlock;
     worker->calBlocks           = allBlocks;
     worker->flatToBias          = flatToBias;
@@ -820,10 +1046,12 @@ void MainWindow::resolveFrames(QList<IntegrationGroup> &newGroups,
                     chosenDir = promptForDirectory(missingPath,
                                                    startDir, errorMsg);
                     if (chosenDir.isEmpty()) break;
+                    // Files may have been copied there since its tree
+                    // was enumerated.
+                    m_dirIndex.refresh(chosenDir);
                     const QString fn = QFileInfo(missingPath).fileName();
-                    const QString found =
-                        FrameResolveWorker::findRecursive(
-                            chosenDir, fn, &m_cancelRequested);
+                    const QString found = m_dirIndex.find(
+                        chosenDir, fn, &m_cancelRequested);
                     if (!found.isEmpty()) break;
                     errorMsg = tr("The selected directory did not contain "
                                   "the file \"%1\". Please try again.")
@@ -851,10 +1079,12 @@ void MainWindow::resolveFrames(QList<IntegrationGroup> &newGroups,
                     chosenDir = promptForMasterDirectory(missingPath,
                                                          startDir, errorMsg);
                     if (chosenDir.isEmpty()) break;
+                    // Files may have been copied there since its tree
+                    // was enumerated.
+                    m_dirIndex.refresh(chosenDir);
                     const QString fn = QFileInfo(missingPath).fileName();
-                    const QString found =
-                        FrameResolveWorker::findRecursive(
-                            chosenDir, fn, &m_cancelRequested);
+                    const QString found = m_dirIndex.find(
+                        chosenDir, fn, &m_cancelRequested);
                     if (!found.isEmpty()) break;
                     errorMsg = tr("The selected directory did not contain "
                                   "the file \"%1\". Please try again.")
@@ -908,62 +1138,10 @@ void MainWindow::resolveFrames(QList<IntegrationGroup> &newGroups,
             auto it = mainCountCache.find(path);
             if (it != mainCountCache.end()) return it.value();
 
-            const QString fileName   = QFileInfo(path).fileName();
-            const QString masterRoot = logToMasterDir.value(logFile);
-
-            auto tryRead = [](const QString &p) -> std::optional<int> {
-                if (p.isEmpty() || !QFile::exists(p)) return std::nullopt;
-                return XisfMasterFrameReader::readFrameCount(p);
-            };
-
-            // Tier 1: original path.
-            if (auto v = tryRead(path)) {
-                mainCountCache.insert(path, v.value_or(-1));
-                return v.value_or(-1);
-            }
-
-            // Tier 2: ../master/ sibling.
-            {
-                const QString found =
-                    FrameResolveWorker::findRecursive(
-                        masterRoot, fileName, nullptr);
-                if (!found.isEmpty()) {
-                    int val =
-                        XisfMasterFrameReader::readFrameCount(found)
-                            .value_or(-1);
-                    mainCountCache.insert(found, val);
-                    mainCountCache.insert(path, val);
-                    return val;
-                }
-            }
-
-            // Tier 3: primary cache.
-            for (const QString &dir :
-                     std::as_const(m_masterCache.primaryDirs)) {
-                QString candidate = QDir(dir).filePath(fileName);
-                if (auto v = tryRead(candidate)) {
-                    mainCountCache.insert(path, v.value_or(-1));
-                    return v.value_or(-1);
-                }
-            }
-
-            // Tier 4: secondary cache (recursive).
-            for (const QString &dir :
-                     std::as_const(m_masterCache.secondaryDirs)) {
-                QString found =
-                    FrameResolveWorker::findRecursive(
-                        dir, fileName, nullptr);
-                if (!found.isEmpty()) {
-                    int val =
-                        XisfMasterFrameReader::readFrameCount(found)
-                            .value_or(-1);
-                    m_masterCache.primaryDirs.insert(
-                        QFileInfo(found).absolutePath());
-                    mainCountCache.insert(found, val);
-                    mainCountCache.insert(path, val);
-                    return val;
-                }
-            }
+            if (auto v = FrameResolveWorker::locateMasterFrameCount(
+                    path, logToMasterDir.value(logFile), m_masterCache,
+                    m_dirIndex, mainCountCache, nullptr))
+                return *v;
 
             mainCountCache.insert(path, -1);
             return -1;
@@ -1021,6 +1199,7 @@ void MainWindow::resolveFrames(QList<IntegrationGroup> &newGroups,
                 }
             }
         }
+        HeaderMetadataCache::save();
     }
 }
 
@@ -1160,7 +1339,8 @@ void MainWindow::rebuildRows()
 
             if (k.date.isValid()) { r.date = k.date; r.hasDate = true; }
 
-            // Take gain / sensorTemp from the first resolved frame.
+            // Take gain / sensorTemp / ISO / f-number from the first
+            // resolved frame.
             for (const auto *fp : bFrames) {
                 if (!fp->resolved) continue;
                 if (fp->gain >= 0) { r.gain = fp->gain; r.hasGain = true; }
@@ -1168,6 +1348,8 @@ void MainWindow::rebuildRows()
                     r.sensorCooling    = fp->sensorTemp;
                     r.hasSensorCooling = true;
                 }
+                if (fp->hasIso)     { r.iso     = fp->iso;     r.hasIso     = true; }
+                if (fp->hasFNumber) { r.fNumber = fp->fNumber; r.hasFNumber = true; }
                 r.duration    = std::round(fp->exposureSec);
                 r.hasBinning  = true;
                 r.binning     = fp->binning;
@@ -13,6 +13,7 @@
 #include "models/integrationgroup.h"
 #include "models/acquisitionrow.h"
 #include "masterfilecache.h"
+#include "directoryindex.h"
 #include "debuglogger.h"
 #include "dialogs/debugresultdialog.h"
 
@@ -24,6 +25,7 @@ class QListWidget;
 class QSplitter;
 class QAction;
 class QPushButton;
+class WbppLogTailer;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -46,6 +48,7 @@ private slots:
     void onAbout();
     void onToggleTheme();
     void onToggleDebugLogging();
+    void onToggleFollowLog();
 
 private:
     void changeFontSize(int delta, bool save = true);
@@ -65,6 +68,7 @@ private:
     QString promptForMasterDirectory(const QString &missingPath,
                                      const QString &startDir,
                                      const QString &errorMessage = {});
+    void stopFollowingLog(bool flush);
     void rebuildRows();
     void updateStatusBar();
     QStringList knownLogTargets() const;
@@ -82,6 +86,9 @@ private:
     // Master file directory cache — persists across Add Log... calls.
     MasterFileCache         m_masterCache;
 
+    // Directory trees searched for missing files — rebuilt for each import.
+    DirectoryIndex          m_dirIndex;
+
     // "groupLabel|strategy" keys for which the calibration conflict warning
     // has already been shown.
     QSet<QString>           m_calConflictWarnedKeys;
@@ -106,6 +113,14 @@ private:
     int                    m_baseFontSize{10};
     QAction               *m_themeAction{nullptr};
     QAction               *m_debugLogAction{nullptr};
+    QAction               *m_followLogAction{nullptr};
+
+    // Live tail of one loaded WBPP log that is still being written, and
+    // the calibration blocks reported for it so far.  resolveFrames uses
+    // these instead of rescanning the growing log.
+    WbppLogTailer         *m_tailer{nullptr};
+    QList<CalibrationBlock> m_tailCalBlocks;
+    QList<FlatBlock>        m_tailFlatBlocks;
 
     QString                m_currentTheme;
 };
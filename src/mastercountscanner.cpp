@@ -0,0 +1,199 @@
+#include "mastercountscanner.h"
+#include <array>
+#include <cstring>
+#include <string_view>
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+static bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static char asciiLower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+}
+
+// True if s holds lit at pos, ignoring ASCII case.  lit is lower case.
+static bool matchesAt(std::string_view s, size_t pos, std::string_view lit)
+{
+    if (pos > s.size() || s.size() - pos < lit.size()) return false;
+    for (size_t i = 0; i < lit.size(); ++i)
+        if (asciiLower(s[pos + i]) != lit[i]) return false;
+    return true;
+}
+
+// First lit at or after from, ignoring ASCII case.  lit is lower case and
+// starts with a letter; both cases of that letter are found with memchr.
+static size_t findNoCase(std::string_view s, std::string_view lit,
+                         size_t from)
+{
+    const char lo = lit[0];
+    const char up = char(lo - 'a' + 'A');
+    while (from < s.size()) {
+        const size_t a = s.find(lo, from);
+        const size_t b = s.find(up, from);
+        const size_t p = qMin(a, b);
+        if (p == std::string_view::npos) break;
+        if (matchesAt(s, p, lit)) return p;
+        from = p + 1;
+    }
+    return std::string_view::npos;
+}
+
+// A double quote, literal or entity-encoded.  Returns its length at pos
+// (0 if there is none).
+static size_t quoteAt(std::string_view s, size_t pos)
+{
+    if (pos < s.size() && s[pos] == '"') return 1;
+    if (matchesAt(s, pos, "&quot;")) return 6;
+    return 0;
+}
+
+// Same, for a quote that ends right before pos.
+static size_t quoteBefore(std::string_view s, size_t pos)
+{
+    if (pos >= 1 && s[pos - 1] == '"') return 1;
+    if (pos >= 6 && matchesAt(s, pos - 6, "&quot;")) return 6;
+    return 0;
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Positive decimal number at pos, or 0.  The number must be followed by a
+// non-digit inside s, so one cut off at the end of a chunk is not taken.
+static int numberAt(std::string_view s, size_t pos)
+{
+    int    n      = 0;
+    size_t digits = 0;
+    while (pos < s.size() && isDigit(s[pos])) {
+        if (++digits > 9) return 0;
+        n = n * 10 + (s[pos] - '0');
+        ++pos;
+    }
+    return pos < s.size() ? n : 0;
+}
+
+// `rows="N"` starting at pos, quoted with quotes of length q.  0 if absent.
+static int rowsAt(std::string_view s, size_t pos, size_t q)
+{
+    if (!matchesAt(s, pos, "rows=")) return 0;
+    size_t p = pos + 5;
+    if (quoteAt(s, p) != q) return 0;
+    p += q;
+    const int n = numberAt(s, p);
+    while (p < s.size() && isDigit(s[p])) ++p;
+    return quoteAt(s, p) == q ? n : 0;
+}
+
+// `rows="N"` ending right before end.  0 if absent.
+static int rowsBefore(std::string_view s, size_t end, size_t q)
+{
+    if (quoteBefore(s, end) != q) return 0;
+    const size_t digitsEnd = end - q;
+    size_t p = digitsEnd;
+    while (p > 0 && isDigit(s[p - 1])) --p;
+    if (p == digitsEnd || quoteBefore(s, p) != q || p < q + 5) return 0;
+    return matchesAt(s, p - q - 5, "rows=") ? numberAt(s, p) : 0;
+}
+
+// `id="images" rows="N"` or `rows="N" id="images"` (either quoting, any
+// ASCII case) around the "images" at pos.
+static int tableRowsAt(std::string_view s, size_t pos)
+{
+    const size_t q = quoteBefore(s, pos);
+    if (q == 0 || pos < q + 3 || !matchesAt(s, pos - q - 3, "id="))
+        return 0;
+    const size_t idBegin = pos - q - 3;
+    const size_t idEnd   = pos + 6 + q;          // past the closing quote
+    if (quoteAt(s, pos + 6) != q) return 0;
+
+    // rows after id.
+    size_t p = idEnd;
+    if (p < s.size() && isBlank(s[p])) {
+        while (p < s.size() && isBlank(s[p])) ++p;
+        if (const int n = rowsAt(s, p, q)) return n;
+    }
+
+    // rows before id.
+    p = idBegin;
+    if (p == 0 || !isBlank(s[p - 1])) return 0;
+    while (p > 0 && isBlank(s[p - 1])) --p;
+    return rowsBefore(s, p, q);
+}
+
+// `ImageIntegration.numberOfImages: N` around the "numberOfImages" at pos.
+static int historyCountAt(std::string_view s, size_t pos)
+{
+    static constexpr std::string_view kPrefix = "ImageIntegration.";
+    if (pos < kPrefix.size()
+            || s.compare(pos - kPrefix.size(), kPrefix.size(), kPrefix) != 0)
+        return 0;
+    size_t p = pos + 14;                     // past "numberOfImages"
+    if (p >= s.size() || s[p] != ':') return 0;
+    ++p;
+    while (p < s.size() && isBlank(s[p])) ++p;
+    return numberAt(s, p);
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+std::optional<int> MasterCountScanner::find(QByteArrayView data)
+{
+    const std::string_view s(data.data(), static_cast<size_t>(data.size()));
+    static constexpr std::string_view kTable   = "images";
+    static constexpr std::string_view kHistory = "numberOfImages";
+
+    // One cursor per anchor; always verify whichever comes first, so the
+    // buffer is walked once and the earliest match in the file wins.
+    size_t nextTable   = findNoCase(s, kTable, 0);
+    size_t nextHistory = s.find(kHistory);
+    while (nextTable != std::string_view::npos
+           || nextHistory != std::string_view::npos) {
+        if (nextTable < nextHistory) {
+            if (const int n = tableRowsAt(s, nextTable)) return n;
+            nextTable = findNoCase(s, kTable, nextTable + 1);
+        } else {
+            if (const int n = historyCountAt(s, nextHistory)) return n;
+            nextHistory = s.find(kHistory, nextHistory + 1);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<int> MasterCountScanner::findInStream(QIODevice     &dev,
+                                                    qint64         maxBytes,
+                                                    QByteArrayView scannedTail)
+{
+    std::array<char, kOverlapBytes + kChunkBytes> buf;
+
+    qsizetype carry = qMin(scannedTail.size(), kOverlapBytes);
+    std::memcpy(buf.data(),
+                scannedTail.data() + scannedTail.size() - carry,
+                static_cast<size_t>(carry));
+
+    qint64 remaining = maxBytes;
+    while (remaining > 0) {
+        const qint64 want = qMin<qint64>(kChunkBytes, remaining);
+        const qint64 got  = dev.read(buf.data() + carry, want);
+        if (got <= 0) break;
+        remaining -= got;
+
+        const qsizetype filled = carry + static_cast<qsizetype>(got);
+        if (auto n = find(QByteArrayView(buf.data(), filled))) return n;
+        if (got < want) break;
+
+        carry = qMin(filled, kOverlapBytes);
+        std::memmove(buf.data(), buf.data() + filled - carry,
+                     static_cast<size_t>(carry));
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <QByteArrayView>
+#include <QIODevice>
+#include <optional>
+
+// ── MasterCountScanner ────────────────────────────────────────────────────
+//
+// Finds the integrated-frame count of a PixInsight master in raw file
+// bytes, without decoding or copying them.  All three forms are searched
+// for in the same pass and the first one found wins:
+//
+//   <table id="images" rows="N">                      literal XML
+//   &lt;table id=&quot;images&quot; rows=&quot;N&quot;  entity-encoded, inside
+//                                                     ProcessingHistory
+//   ImageIntegration.numberOfImages: N                old HISTORY comment
+//
+// As with the XML reader and regexes this replaces, the table forms match
+// in any ASCII case and with rows before id as well as after it.  The
+// HISTORY form is matched exactly.
+//
+// Candidates are located with memchr-backed search on the anchors
+// "images" (either case of its first letter, the rest compared without
+// regard to case) and "numberOfImages", and only then verified in place.
+//
+// Streams are scanned in fixed chunks that reuse one buffer.  The last
+// kOverlapBytes of each chunk are carried into the next, so a match that
+// straddles a chunk boundary is still found.
+// ─────────────────────────────────────────────────────────────────────────
+class MasterCountScanner {
+public:
+    static constexpr qsizetype kChunkBytes   = 64 * 1024;
+    static constexpr qsizetype kOverlapBytes = 256;   // > longest match
+
+    // First count in data, or nullopt.
+    static std::optional<int> find(QByteArrayView data);
+
+    // Continues a scan from dev's current position for at most maxBytes.
+    // scannedTail is the end of the bytes already passed to find(); it
+    // supplies the overlap for the first chunk.
+    static std::optional<int> findInStream(QIODevice      &dev,
+                                           qint64          maxBytes,
+                                           QByteArrayView  scannedTail = {});
+};
@@ -2,6 +2,7 @@
 #include <QSet>
 #include <QList>
 #include <QString>
+#include "pathrewriterules.h"
 
 // Persistent cache of master calibration file directories, owned by
 // MainWindow and passed by pointer into FrameResolveWorker.
@@ -11,9 +12,20 @@ struct MasterFileCache {
     // Checked with QFile::exists() before any recursive search.
     QSet<QString>  primaryDirs;
 
-    // User-supplied directories searched recursively via findRecursive().
+    // User-supplied directories searched recursively through DirectoryIndex.
     QList<QString> secondaryDirs;
 
+    // "path\nmaster root" of masters that tiers 1–4 did not find in this
+    // import.  Cleared whenever a directory is added to either list above,
+    // and at the start of each import.
+    QSet<QString>  missing;
+
+    // Prefix rewrites in effect for this import, newest first: those
+    // recorded for the loaded logs plus those learned since.  Tried on
+    // frames and masters missing at their original path, before any
+    // search; a rewritten path is only used if it exists.
+    QList<PathRewriteRules::Rule> rewrites;
+
     // Set to true when the user cancels a master directory prompt.
     // Suppresses further prompts for the remainder of the current import.
     // Reset to false at the start of each Add Log... call.
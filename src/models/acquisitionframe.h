@@ -27,6 +27,10 @@ struct AcquisitionFrame {
     QString          filter;            // FILTER keyword value
     QString          object;            // OBJECT keyword value
     int              binning{1};        // XBINNING
+    int              iso{-1};           // ISO
+    bool             hasIso{false};
+    double           fNumber{-1};       // FOCRATIO
+    bool             hasFNumber{false};
 
     // ── Calibration chain (set by FrameResolveWorker) ─────────────────────
     FrameCalibration calibration;
@@ -0,0 +1,88 @@
+#include "pagecachehints.h"
+
+#ifdef Q_OS_UNIX
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#endif
+
+// macOS has no posix_fadvise; there the hints compile to nothing.
+#if defined(Q_OS_UNIX) && defined(POSIX_FADV_DONTNEED)
+#  define HAVE_POSIX_FADVISE 1
+#endif
+
+QAtomicInt PageCacheHints::s_enabled{1};
+QAtomicInt PageCacheHints::s_dropAfterRead{0};
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+static void advise(int fd, qint64 offset, qint64 length, int advice)
+{
+#ifdef HAVE_POSIX_FADVISE
+    if (fd < 0 || !PageCacheHints::enabled()) return;
+    posix_fadvise(fd, off_t(offset), off_t(length), advice);
+#else
+    Q_UNUSED(fd) Q_UNUSED(offset) Q_UNUSED(length) Q_UNUSED(advice)
+#endif
+}
+
+#ifdef HAVE_POSIX_FADVISE
+static constexpr int kWillNeed = POSIX_FADV_WILLNEED;
+static constexpr int kRandom   = POSIX_FADV_RANDOM;
+static constexpr int kDontNeed = POSIX_FADV_DONTNEED;
+#else
+static constexpr int kWillNeed = 0;
+static constexpr int kRandom   = 0;
+static constexpr int kDontNeed = 0;
+#endif
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void PageCacheHints::setEnabled(bool enabled)
+{
+    s_enabled.storeRelaxed(enabled ? 1 : 0);
+}
+
+bool PageCacheHints::enabled()
+{
+    return s_enabled.loadRelaxed() != 0;
+}
+
+void PageCacheHints::setDropAfterRead(bool drop)
+{
+    s_dropAfterRead.storeRelaxed(drop ? 1 : 0);
+}
+
+bool PageCacheHints::dropAfterRead()
+{
+    return s_dropAfterRead.loadRelaxed() != 0;
+}
+
+void PageCacheHints::willNeed(int fd, qint64 offset, qint64 length)
+{
+    advise(fd, offset, length, kWillNeed);
+}
+
+void PageCacheHints::randomAccess(int fd)
+{
+    advise(fd, 0, 0, kRandom);
+}
+
+void PageCacheHints::randomAccess(const uchar *mapped, qint64 size)
+{
+#ifdef Q_OS_UNIX
+    if (mapped && size > 0 && enabled())
+        posix_madvise(const_cast<uchar *>(mapped), size_t(size),
+                      POSIX_MADV_RANDOM);
+#else
+    Q_UNUSED(mapped) Q_UNUSED(size)
+#endif
+}
+
+void PageCacheHints::dontNeed(int fd, qint64 offset, qint64 length)
+{
+    if (dropAfterRead()) advise(fd, offset, length, kDontNeed);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <QAtomicInt>
+#include <QtGlobal>
+
+// ── PageCacheHints ────────────────────────────────────────────────────────
+//
+// posix_fadvise() hints for header reads.  Only a few kilobytes at the
+// start of each frame are needed, but the kernel's default readahead pulls
+// in megabytes of pixel data behind them.  On a large import that evicts
+// useful pages from the page cache.  The readers therefore:
+//
+//   - announce the header range of the frames about to be read (WILLNEED),
+//     so the kernel fetches them in parallel;
+//   - switch each opened or mapped file to RANDOM access, which disables
+//     readahead;
+//   - optionally drop the pages they read once the header is consumed
+//     (DONTNEED).  The kernel cannot tell pages this read brought in from
+//     ones that were cached before, so this also evicts headers that
+//     another program, or an earlier import, had cached; it is off unless
+//     setDropAfterRead(true) is called.
+//
+// Hints can be switched off (they are on by default); MainWindow applies
+// the user's AppSettings choice at start-up.  On platforms without
+// posix_fadvise (macOS) the file-descriptor hints are no-ops.
+// ─────────────────────────────────────────────────────────────────────────
+class PageCacheHints {
+public:
+    static void setEnabled(bool enabled);
+    static bool enabled();
+
+    // dontNeed() does nothing unless this is on (and hints are enabled).
+    static void setDropAfterRead(bool drop);
+    static bool dropAfterRead();
+
+    // fd is a file descriptor, e.g. QFile::handle(); -1 is ignored.  A
+    // length of 0 means "to the end of the file".
+    static void willNeed(int fd, qint64 offset, qint64 length);
+    static void randomAccess(int fd);
+    static void randomAccess(const uchar *mapped, qint64 size);  // mmap'd
+    static void dontNeed(int fd, qint64 offset, qint64 length);
+
+private:
+    static QAtomicInt s_enabled;
+    static QAtomicInt s_dropAfterRead;
+};
@@ -0,0 +1,202 @@
+#include "pathrewriterules.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+static constexpr quint32 kMagic   = 0x41425052;   // "ABPR"
+static constexpr quint32 kVersion = 1;
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+using Rule = PathRewriteRules::Rule;
+
+static QDataStream &operator<<(QDataStream &out, const Rule &r)
+{
+    return out << r.from << r.to;
+}
+
+static QDataStream &operator>>(QDataStream &in, Rule &r)
+{
+    return in >> r.from >> r.to;
+}
+
+struct RulesState {
+    QMutex                       mutex;
+    bool                         loaded{false};
+    bool                         dirty{false};
+    QHash<QString, QList<Rule>>  logs;      // canonical log path → rules
+};
+
+static RulesState &state()
+{
+    static RulesState s;
+    return s;
+}
+
+// Called with the mutex held.
+static void ensureLoaded(RulesState &s)
+{
+    if (s.loaded) return;
+    s.loaded = true;
+
+    QFile f(PathRewriteRules::cacheFilePath());
+    if (!f.open(QIODevice::ReadOnly)) return;
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != kMagic || version != kVersion) return;
+
+    qint32 logs = 0;
+    in >> logs;
+    for (qint32 i = 0; i < logs && in.status() == QDataStream::Ok; ++i) {
+        QString log;
+        qint32  n = 0;
+        in >> log >> n;
+        QList<Rule> rules;
+        for (qint32 k = 0; k < n && in.status() == QDataStream::Ok; ++k) {
+            Rule r;
+            in >> r;
+            rules << r;
+        }
+        s.logs.insert(log, rules);
+    }
+    if (in.status() != QDataStream::Ok) s.logs.clear();
+}
+
+static QString logKey(const QString &logPath)
+{
+    const QFileInfo fi(logPath);
+    const QString canonical = fi.canonicalFilePath();
+    return canonical.isEmpty() ? fi.absoluteFilePath() : canonical;
+}
+
+// Log paths written on Windows use backslashes, whatever the platform the
+// log is read on.
+static QString normalized(const QString &path)
+{
+    QString p = path;
+    p.replace(QLatin1Char('\\'), QLatin1Char('/'));
+    while (p.size() > 1 && p.endsWith(QLatin1Char('/'))) p.chop(1);
+    return p;
+}
+
+// Windows roots ("D:/...") compare without regard to case.
+static bool covers(const QString &root, const QString &path)
+{
+    const Qt::CaseSensitivity cs =
+        root.size() >= 2 && root.at(1) == QLatin1Char(':')
+            ? Qt::CaseInsensitive : Qt::CaseSensitive;
+    return path.startsWith(root, cs)
+        && (path.size() == root.size()
+            || path.at(root.size()) == QLatin1Char('/'));
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+QString PathRewriteRules::cacheFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+           + QStringLiteral("/pathrewrites.bin");
+}
+
+std::optional<Rule> PathRewriteRules::infer(const QString &oldPath,
+                                            const QString &newPath)
+{
+    const QStringList o = normalized(oldPath).split(QLatin1Char('/'));
+    const QStringList n =
+        normalized(QDir::cleanPath(QFileInfo(newPath).absoluteFilePath()))
+            .split(QLatin1Char('/'));
+
+    qsizetype shared = 0;
+    while (shared < o.size() && shared < n.size()
+           && o.at(o.size() - 1 - shared) == n.at(n.size() - 1 - shared))
+        ++shared;
+    if (shared == 0) return std::nullopt;
+
+    Rule rule;
+    rule.from = o.mid(0, o.size() - shared).join(QLatin1Char('/'));
+    rule.to   = n.mid(0, n.size() - shared).join(QLatin1Char('/'));
+    // A filesystem root on either side would make the rule cover too much.
+    if (rule.from.isEmpty() || rule.to.isEmpty() || rule.from == rule.to)
+        return std::nullopt;
+    return rule;
+}
+
+QString PathRewriteRules::rewrite(const QList<Rule> &rules,
+                                  const QString     &path,
+                                  Rule              *used)
+{
+    if (rules.isEmpty() || path.isEmpty()) return {};
+    const QString p = normalized(path);
+    for (const Rule &r : rules) {
+        if (!covers(r.from, p)) continue;
+        if (used) *used = r;
+        return r.to + p.mid(r.from.size());
+    }
+    return {};
+}
+
+QList<Rule> PathRewriteRules::forLog(const QString &logPath)
+{
+    QList<Rule> rules;
+    {
+        RulesState &s = state();
+        QMutexLocker lk(&s.mutex);
+        ensureLoaded(s);
+        rules = s.logs.value(logKey(logPath));
+    }
+    // The data may have moved back, or on to somewhere else.
+    QList<Rule> valid;
+    for (const Rule &r : std::as_const(rules))
+        if (!QFileInfo::exists(r.from) && QFileInfo::exists(r.to))
+            valid << r;
+    return valid;
+}
+
+bool PathRewriteRules::record(const QString &logPath, const Rule &rule)
+{
+    RulesState &s = state();
+    QMutexLocker lk(&s.mutex);
+    ensureLoaded(s);
+    QList<Rule> &rules = s.logs[logKey(logPath)];
+    if (!rules.isEmpty() && rules.constFirst() == rule) return false;
+    const bool known = rules.removeAll(rule) > 0;
+    rules.prepend(rule);
+    if (rules.size() > kMaxRulesPerLog) rules.resize(kMaxRulesPerLog);
+    s.dirty = true;
+    return !known;
+}
+
+void PathRewriteRules::save()
+{
+    RulesState &s = state();
+    QMutexLocker lk(&s.mutex);
+    if (!s.dirty) return;
+
+    const QString file = cacheFilePath();
+    if (!QDir().mkpath(QFileInfo(file).absolutePath())) return;
+
+    QSaveFile f(file);
+    if (!f.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kMagic << kVersion << qint32(s.logs.size());
+    for (auto it = s.logs.constBegin(); it != s.logs.constEnd(); ++it) {
+        out << it.key() << qint32(it->size());
+        for (const Rule &r : *it) out << r;
+    }
+    if (out.status() == QDataStream::Ok && f.commit())
+        s.dirty = false;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <QList>
+#include <QString>
+#include <optional>
+
+// ── PathRewriteRules ──────────────────────────────────────────────────────
+//
+// Prefix rewrites for logs written on another machine or before the data
+// was moved, e.g. D:\Astro → /mnt/nas/Astro.  Once one frame or master of
+// such a log has been found by searching, infer() derives the rule from
+// its old and new path.  Every other path under the same old root that is
+// missing is then tried at its rewritten path, a string operation and a
+// stat, before it is searched for.  A rewritten path that does not exist
+// is not used.
+//
+// Rules are remembered per log in one binary file under
+// AppLocalDataLocation, loaded on first use and written back by save(), so
+// later imports of the log need no search at all.  A rule is recorded for
+// a log only once it has located a frame or master of that log.  All
+// functions are thread-safe.
+// ─────────────────────────────────────────────────────────────────────────
+class PathRewriteRules {
+public:
+    static constexpr int kMaxRulesPerLog = 8;
+
+    // Paths use '/' separators and have no trailing separator.
+    struct Rule {
+        QString from;   // old root
+        QString to;     // new root
+    };
+
+    // The rule that turns oldPath into newPath: the roots left when the
+    // path components the two share at their end are removed.  nullopt if
+    // the file names differ or nothing but the file name would change.
+    static std::optional<Rule> infer(const QString &oldPath,
+                                     const QString &newPath);
+
+    // path under the old root of the first rule that covers it, moved to
+    // that rule's new root; that rule is stored in used, if given.  Empty
+    // if no rule covers path.
+    static QString rewrite(const QList<Rule> &rules, const QString &path,
+                           Rule *used = nullptr);
+
+    // Rules recorded for logPath, newest first.  Rules whose old root
+    // exists on this machine or whose new root does not are left out.
+    static QList<Rule> forLog(const QString &logPath);
+
+    // Remembers rule for logPath.  False if it was already known.
+    static bool record(const QString &logPath, const Rule &rule);
+
+    // Writes the rules file if a rule was recorded since the last save.
+    // Failures are silently ignored.
+    static void save();
+
+    static QString cacheFilePath();
+};
+
+inline bool operator==(const PathRewriteRules::Rule &a,
+                       const PathRewriteRules::Rule &b)
+{
+    return a.from == b.from && a.to == b.to;
+}
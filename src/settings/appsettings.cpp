@@ -289,3 +289,31 @@ void AppSettings::setFontSize(int pt)
 {
     QSettings s = qs(); s.setValue(QStringLiteral("fontSize"), pt);
 }
+
+bool AppSettings::pageCacheHints() const
+{
+    return qs().value(QStringLiteral("pageCacheHints"), true).toBool();
+}
+void AppSettings::setPageCacheHints(bool on)
+{
+    QSettings s = qs(); s.setValue(QStringLiteral("pageCacheHints"), on);
+}
+
+bool AppSettings::dropHeaderPages() const
+{
+    return qs().value(QStringLiteral("dropHeaderPages"), false).toBool();
+}
+void AppSettings::setDropHeaderPages(bool on)
+{
+    QSettings s = qs(); s.setValue(QStringLiteral("dropHeaderPages"), on);
+}
+
+int AppSettings::headerIoThreads() const
+{
+    return qBound(1, qs().value(QStringLiteral("headerIoThreads"), 4).toInt(),
+                  16);
+}
+void AppSettings::setHeaderIoThreads(int n)
+{
+    QSettings s = qs(); s.setValue(QStringLiteral("headerIoThreads"), n);
+}
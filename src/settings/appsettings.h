@@ -72,6 +72,18 @@ public:
     int  fontSize() const;
     void setFontSize(int pt);
 
+    // See PageCacheHints.  Hints default to on, dropping pages to off.
+    bool pageCacheHints() const;
+    void setPageCacheHints(bool on);
+
+    bool dropHeaderPages() const;
+    void setDropHeaderPages(bool on);
+
+    // Threads in each of HeaderPipeline's locate and I/O stages (1–16).
+    // Not in the UI; more helps on NAS shares with high latency.
+    int  headerIoThreads() const;
+    void setHeaderIoThreads(int n);
+
 private:
     AppSettings() = default;
 };
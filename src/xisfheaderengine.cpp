@@ -0,0 +1,454 @@
+#include "xisfheaderengine.h"
+#include "debuglogger.h"
+#include "mastercountscanner.h"
+#include "pagecachehints.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QStorageInfo>
+#include <QVarLengthArray>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+// ── Zero-copy FITSKeyword scanner ─────────────────────────────────────────
+
+static bool isXmlSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static QByteArrayView trimmedView(QByteArrayView s)
+{
+    qsizetype b = 0, e = s.size();
+    while (b < e && isXmlSpace(s[b]))     ++b;
+    while (e > b && isXmlSpace(s[e - 1])) --e;
+    return s.sliced(b, e - b);
+}
+
+// ASCII case-insensitive comparison against an upper-case name.
+static bool equalsUpper(QByteArrayView s, QByteArrayView upper)
+{
+    if (s.size() != upper.size()) return false;
+    for (qsizetype i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - ('a' - 'A'));
+        if (c != upper[i]) return false;
+    }
+    return true;
+}
+
+// Value of attribute attr in the attribute list that starts at s (just
+// after the element name), or a null view.  Parsing stops at the end of
+// the start tag, so a '>' inside a quoted value is handled.
+static QByteArrayView attributeValue(QByteArrayView s, QByteArrayView attr)
+{
+    const char *p = s.data(), *end = p + s.size();
+    while (p < end) {
+        while (p < end && isXmlSpace(*p)) ++p;
+        if (p >= end || *p == '>' || *p == '/') return {};
+        const char *nameBegin = p;
+        while (p < end && *p != '=' && !isXmlSpace(*p)) ++p;
+        const qsizetype nameLen = p - nameBegin;
+        while (p < end && isXmlSpace(*p)) ++p;
+        if (p >= end || *p != '=') return {};
+        ++p;
+        while (p < end && isXmlSpace(*p)) ++p;
+        if (p >= end || (*p != '"' && *p != '\'')) return {};
+        const char quote = *p++;
+        const char *valueBegin = p;
+        while (p < end && *p != quote) ++p;
+        if (p >= end) return {};
+        if (nameLen == attr.size()
+                && std::memcmp(nameBegin, attr.data(), nameLen) == 0)
+            return QByteArrayView(valueBegin, p - valueBegin);
+        ++p;
+    }
+    return {};
+}
+
+// Attribute text with the predefined and numeric XML entities replaced.
+static QString decodeAttribute(QByteArrayView raw)
+{
+    if (!raw.contains('&')) return QString::fromUtf8(raw);
+
+    static const struct { const char *entity; char ch; } kEntities[] = {
+        { "&amp;", '&' }, { "&lt;", '<' }, { "&gt;", '>' },
+        { "&quot;", '"' }, { "&apos;", '\'' },
+    };
+    QString out;
+    qsizetype i = 0;
+    while (i < raw.size()) {
+        const qsizetype amp = raw.indexOf('&', i);
+        if (amp < 0) {
+            out += QString::fromUtf8(raw.sliced(i));
+            break;
+        }
+        out += QString::fromUtf8(raw.sliced(i, amp - i));
+        const qsizetype semi = raw.indexOf(';', amp);
+        const QByteArrayView ent =
+            semi < 0 ? QByteArrayView() : raw.sliced(amp, semi - amp + 1);
+        bool replaced = false;
+        for (const auto &e : kEntities)
+            if (ent.size() == qsizetype(std::strlen(e.entity))
+                    && std::memcmp(ent.data(), e.entity, ent.size()) == 0) {
+                out += QLatin1Char(e.ch);
+                replaced = true;
+                break;
+            }
+        if (!replaced && ent.size() > 3 && ent[1] == '#') {
+            bool ok = false;
+            const QByteArray num = ent.toByteArray();
+            const uint cp = ent[2] == 'x'
+                ? num.sliced(3, num.size() - 4).toUInt(&ok, 16)
+                : num.sliced(2, num.size() - 3).toUInt(&ok, 10);
+            if (ok) {
+                const char32_t c = cp;
+                out += QString::fromUcs4(&c, 1);
+                replaced = true;
+            }
+        }
+        if (replaced) {
+            i = semi + 1;
+        } else {
+            out += QLatin1Char('&');
+            i = amp + 1;
+        }
+    }
+    return out;
+}
+
+// Keyword-only queries skip the general XML parser: every
+// <FITSKeyword name="..." value="..."/> is located in the raw bytes and its
+// name compared in place, so keywords that are not wanted cost no
+// allocation.  Stops as soon as every wanted keyword has a value.
+static void scanKeywords(const QByteArray      &xmlData,
+                         const XisfHeaderQuery &q,
+                         XisfHeaderValues      &v)
+{
+    QVarLengthArray<QByteArray, 16> wanted;
+    if (!q.keywordIndex)
+        for (const QString &kw : q.keywords) wanted.append(kw.toLatin1());
+
+    static constexpr QByteArrayView kTag("<FITSKeyword");
+    const QByteArrayView data(xmlData);
+    qsizetype pos = 0;
+    while ((pos = xmlData.indexOf(kTag, pos)) >= 0) {
+        pos += kTag.size();
+        if (pos >= data.size() || !isXmlSpace(data[pos])) continue;
+
+        const QByteArrayView attrs = data.sliced(pos);
+        const QByteArrayView name =
+            trimmedView(attributeValue(attrs, "name"));
+        qsizetype i = -1;
+        if (q.keywordIndex) {
+            i = q.keywordIndex(name);
+        } else {
+            for (qsizetype k = 0; k < wanted.size() && i < 0; ++k)
+                if (equalsUpper(name, wanted[k])) i = k;
+        }
+        if (i < 0 || i >= q.keywords.size()) continue;
+
+        const QString &kw = q.keywords.at(i);
+        if (v.keywords.contains(kw)) continue;
+        const QByteArrayView value =
+            trimmedView(attributeValue(attrs, "value"));
+        if (!value.isEmpty())
+            v.keywords.insert(kw, decodeAttribute(value));
+        if (v.keywords.size() == q.keywords.size()) return;
+    }
+}
+
+// ── Attached properties ───────────────────────────────────────────────────
+
+struct Attachment {
+    qint64 offset;
+    qint64 size;
+};
+
+// Where the data of <Property id="id" location="attachment:offset:size"/>
+// is stored in the file.  nullopt if the property is absent, stored inline
+// or compressed.
+static std::optional<Attachment> propertyAttachment(const QByteArray &xmlData,
+                                                    QByteArrayView    id)
+{
+    static constexpr QByteArrayView kTag("<Property");
+    static constexpr QByteArrayView kPrefix("attachment:");
+    const QByteArrayView data(xmlData);
+    qsizetype pos = 0;
+    while ((pos = xmlData.indexOf(kTag, pos)) >= 0) {
+        pos += kTag.size();
+        if (pos >= data.size() || !isXmlSpace(data[pos])) continue;
+
+        const QByteArrayView attrs = data.sliced(pos);
+        const QByteArrayView pid   = trimmedView(attributeValue(attrs, "id"));
+        if (pid.size() != id.size()
+                || std::memcmp(pid.data(), id.data(), id.size()) != 0)
+            continue;
+
+        const QByteArrayView loc =
+            trimmedView(attributeValue(attrs, "location"));
+        if (!loc.startsWith(kPrefix)
+                || !attributeValue(attrs, "compression").isNull())
+            return std::nullopt;
+
+        const QList<QByteArray> parts =
+            loc.sliced(kPrefix.size()).toByteArray().split(':');
+        if (parts.size() != 2) return std::nullopt;
+        bool okOffset = false, okSize = false;
+        const Attachment a{ parts[0].toLongLong(&okOffset),
+                            parts[1].toLongLong(&okSize) };
+        if (!okOffset || !okSize || a.offset < 16 || a.size <= 0)
+            return std::nullopt;
+        return a;
+    }
+    return std::nullopt;
+}
+
+// ── Header bytes ──────────────────────────────────────────────────────────
+
+QAtomicInt XisfHeaderEngine::s_memoryMapping{1};
+
+// mmap is only used on local filesystems: on a network mount every page
+// fault is a round trip, and a file truncated on the server while mapped
+// raises SIGBUS.  The answer is cached per directory.
+static bool isLocalFileSystem(const QString &path)
+{
+    static QMutex               mutex;
+    static QHash<QString, bool> byDir;
+
+    const QString dir = QFileInfo(path).absolutePath();
+    {
+        QMutexLocker lk(&mutex);
+        const auto it = byDir.constFind(dir);
+        if (it != byDir.constEnd()) return it.value();
+    }
+
+    static const char *const kRemote[] = {
+        "nfs", "cifs", "smb", "afpfs", "webdav", "davfs", "9p",
+        "fuse.sshfs", "fuse.rclone",
+    };
+    const QByteArray type = QStorageInfo(dir).fileSystemType().toLower();
+    bool local = !type.isEmpty();
+    for (const char *r : kRemote)
+        if (type.startsWith(r)) local = false;
+
+    QMutexLocker lk(&mutex);
+    byDir.insert(dir, local);
+    return local;
+}
+
+// The start of an XISF file: mapped, fetched with one speculative read of
+// kSpeculativeBytes that is only extended when a caller needs more, or
+// handed in already read.  In the last case the file is only opened if
+// more is needed.
+class HeaderBytes {
+public:
+    HeaderBytes(QFile &f, bool map, const QByteArray &prefetched)
+        : m_file(f)
+    {
+        if (!prefetched.isEmpty()) {
+            m_buf = prefetched;
+            m_eof = m_buf.size() < XisfHeaderEngine::kSpeculativeBytes;
+            return;
+        }
+        if (map && f.size() > 0)
+            m_map = f.map(0, f.size());
+        if (m_map) {
+            PageCacheHints::randomAccess(m_map, f.size());
+        } else {
+            PageCacheHints::randomAccess(f.handle());
+            m_buf = f.read(XisfHeaderEngine::kSpeculativeBytes);
+            m_eof = m_buf.size() < XisfHeaderEngine::kSpeculativeBytes;
+        }
+    }
+
+    // The pages read for the header are not needed again.
+    ~HeaderBytes()
+    {
+        if (m_map) m_file.unmap(const_cast<uchar *>(m_map));
+        if (m_file.isOpen())
+            PageCacheHints::dontNeed(
+                m_file.handle(), 0,
+                qMax(m_mapExtent, qMax<qint64>(m_buf.size(), m_file.pos())));
+    }
+
+    // The first n bytes of the file (fewer at end of file).  Invalidates
+    // views returned by earlier calls.
+    QByteArrayView first(qint64 n)
+    {
+        if (m_map)
+            return mapped(n);
+        if (m_buf.size() < n && !m_eof && stream()) {
+            const QByteArray more = m_file.read(n - m_buf.size());
+            m_eof = m_buf.size() + more.size() < n;
+            m_buf += more;
+        }
+        return QByteArrayView(m_buf).first(qMin<qint64>(n, m_buf.size()));
+    }
+
+    // The first n bytes (fewer at end of file) as far as they are already
+    // in memory; never reads.
+    QByteArrayView held(qint64 n) const
+    {
+        if (m_map)
+            return mapped(n);
+        return QByteArrayView(m_buf).first(qMin<qint64>(n, m_buf.size()));
+    }
+
+    // True if bytes before offset n are neither held nor past end of file.
+    bool moreBefore(qint64 n) const
+    {
+        return !m_map && !m_eof && m_buf.size() < n;
+    }
+
+    // The open file, positioned at the end of the held bytes; nullptr if
+    // it cannot be opened.
+    QFile *stream()
+    {
+        if (!m_file.isOpen()) {
+            if (!m_file.open(QIODevice::ReadOnly)) return nullptr;
+            PageCacheHints::randomAccess(m_file.handle());
+            if (!m_file.seek(m_buf.size())) return nullptr;
+        }
+        return &m_file;
+    }
+
+    // Bytes [from, to) of what is available, without copying.
+    QByteArray range(qint64 from, qint64 to)
+    {
+        const QByteArrayView v = first(to);
+        if (from >= v.size()) return {};
+        return QByteArray::fromRawData(v.data() + from, v.size() - from);
+    }
+
+private:
+    QByteArrayView mapped(qint64 n) const
+    {
+        const qint64 size = qMin(n, m_file.size());
+        m_mapExtent = qMax(m_mapExtent, size);
+        return QByteArrayView(m_map, size);
+    }
+
+    QFile         &m_file;
+    const uchar   *m_map{nullptr};
+    mutable qint64 m_mapExtent{0};    // bytes of the mapping handed out
+    QByteArray     m_buf;
+    bool           m_eof{false};
+};
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void XisfHeaderEngine::setMemoryMapping(bool enabled)
+{
+    s_memoryMapping.storeRelaxed(enabled ? 1 : 0);
+}
+
+bool XisfHeaderEngine::memoryMapping()
+{
+    return s_memoryMapping.loadRelaxed() != 0;
+}
+
+std::optional<XisfHeaderValues> XisfHeaderEngine::read(
+    const QString &path, const XisfHeaderQuery &query,
+    const QByteArray &prefetched)
+{
+    auto &dbg = DebugLogger::instance();
+
+    QFile f(path);
+    if (prefetched.isEmpty() && !f.open(QIODevice::ReadOnly)) {
+        if (dbg.isSessionActive())
+            dbg.logWarning(QStringLiteral("XISF: cannot open '%1'")
+                               .arg(QFileInfo(path).fileName()));
+        return std::nullopt;
+    }
+
+    HeaderBytes bytes(f, memoryMapping() && isLocalFileSystem(path),
+                      prefetched);
+
+    // ── Fixed 16-byte preamble: magic, XML length, reserved ──────────────
+    const QByteArrayView preamble = bytes.first(16);
+    if (preamble.size() < 16 || !preamble.startsWith("XISF0100")) {
+        if (dbg.isSessionActive())
+            dbg.logWarning(QStringLiteral("XISF: bad magic bytes in '%1'")
+                               .arg(QFileInfo(path).fileName()));
+        return std::nullopt;
+    }
+
+    const quint32 xmlLen =
+        static_cast<quint8>(preamble[ 8])         |
+        (static_cast<quint8>(preamble[ 9]) <<  8) |
+        (static_cast<quint8>(preamble[10]) << 16) |
+        (static_cast<quint8>(preamble[11]) << 24);
+
+    XisfHeaderValues values;
+    const bool xmlUsable = xmlLen > 0 && xmlLen <= kMaxXmlBytes;
+
+    if (!query.keywords.isEmpty() && xmlUsable) {
+        // Usually already inside the speculative read; a larger XML block
+        // costs exactly one follow-up read.
+        scanKeywords(bytes.range(16, 16 + qint64(xmlLen)), query, values);
+    }
+
+    if (query.frameCount) {
+        if (!xmlUsable) {
+            // No usable XML block: scan the start of the file blindly.
+            const QByteArrayView held = bytes.held(kRawScanBytes).sliced(16);
+            values.frameCount = MasterCountScanner::find(held);
+            if (!values.frameCount && bytes.moreBefore(kRawScanBytes)) {
+                if (QFile *in = bytes.stream())
+                    values.frameCount = MasterCountScanner::findInStream(
+                        *in, kRawScanBytes - 16 - held.size(), held);
+            }
+            return values;
+        }
+
+        // The XML block itself: what is already in memory first, then the
+        // rest of it.
+        const qint64 xmlEnd  = 16 + qint64(xmlLen);
+        const qsizetype seen = bytes.held(xmlEnd).size() - 16;
+        values.frameCount =
+            MasterCountScanner::find(bytes.held(xmlEnd).sliced(16));
+        if (values.frameCount) return values;
+
+        const QByteArray xmlData = bytes.range(16, xmlEnd);
+        if (xmlData.size() > seen) {
+            const qsizetype from =
+                qMax<qsizetype>(0, seen - MasterCountScanner::kOverlapBytes);
+            values.frameCount = MasterCountScanner::find(
+                QByteArrayView(xmlData).sliced(from));
+            if (values.frameCount) return values;
+        }
+
+        // A large ProcessingHistory is stored as an attached block; read
+        // exactly its byte range.
+        const auto att = propertyAttachment(
+            xmlData, "PixInsight:ProcessingHistory");
+        if (!att || att->offset + att->size > f.size()) {
+            if (dbg.isSessionActive())
+                dbg.logDecision(QStringLiteral(
+                    "XISF: no frame count in the header of '%1'")
+                        .arg(QFileInfo(path).fileName()));
+            return values;
+        }
+        if (dbg.isSessionActive())
+            dbg.logDecision(QStringLiteral(
+                "XISF: reading attached ProcessingHistory of '%1' "
+                "(%2 bytes at %3)")
+                    .arg(QFileInfo(path).fileName())
+                    .arg(att->size).arg(att->offset));
+
+        const QByteArrayView held = bytes.held(att->offset + att->size);
+        if (held.size() == att->offset + att->size)
+            values.frameCount = MasterCountScanner::find(
+                held.sliced(att->offset));
+        else if (QFile *in = bytes.stream(); in && in->seek(att->offset))
+            values.frameCount =
+                MasterCountScanner::findInStream(*in, att->size);
+    }
+    return values;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <optional>
+
+// What to extract from one XISF header.  Any combination is answered from a
+// single open and a single read of the header block.
+struct XisfHeaderQuery {
+    QStringList keywords;                 // FITSKeyword names, upper case
+    bool        frameCount{false};        // integrated frames of a master
+
+    // Optional: index into keywords of a FITSKeyword name (any case), or
+    // -1.  Lets a caller with a precomputed lookup skip the comparison
+    // against every wanted name.
+    int (*keywordIndex)(QByteArrayView name){nullptr};
+};
+
+struct XisfHeaderValues {
+    QHash<QString, QString> keywords;       // first non-empty value of each
+                                            // keyword, quotes not stripped
+    std::optional<int>      frameCount;
+};
+
+// ── XisfHeaderEngine ──────────────────────────────────────────────────────
+//
+// The one place that opens an XISF file, validates the XISF0100 signature
+// and reads the XML header block.  Frame metadata (XisfHeaderReader) and
+// master frame counts (XisfMasterFrameReader) are both queries against it.
+//
+// Keywords are found by a hand-written scanner that locates the
+// FITSKeyword elements in the raw bytes, compares names in place and stops
+// once every wanted keyword is found.  Frame counts are left to
+// MasterCountScanner.  It searches the XML block, then the
+// PixInsight:ProcessingHistory property if that is stored as an attached
+// block (location="attachment:offset:size"), reading exactly its byte
+// range.  Only a file without a usable XML block is scanned blindly, up to
+// kRawScanBytes.
+//
+// The file is read with one speculative kSpeculativeBytes read, which
+// covers the preamble and the XML block of almost every frame; only a
+// larger header costs a second read.  Each small read is a round trip on
+// SMB/NFS mounts.
+// ─────────────────────────────────────────────────────────────────────────
+class XisfHeaderEngine {
+public:
+    static constexpr quint32 kMaxXmlBytes      = 10 * 1024 * 1024;  // 10 MB
+    static constexpr qint64  kRawScanBytes     = 256 * 1024;        // 256 KB
+    static constexpr qint64  kSpeculativeBytes = 64 * 1024;         // 64 KB
+
+    // nullopt if the file cannot be opened or is not an XISF file.
+    // prefetched, if not empty, holds the first kSpeculativeBytes of the
+    // file (fewer only at end of file), e.g. from BatchHeaderIo; the file
+    // is then opened only if more is needed.
+    static std::optional<XisfHeaderValues> read(
+        const QString         &path,
+        const XisfHeaderQuery &query,
+        const QByteArray      &prefetched = {});
+
+    // Files on local filesystems are memory-mapped instead of read (on by
+    // default).  Network mounts always use the speculative read.
+    static void setMemoryMapping(bool enabled);
+    static bool memoryMapping();
+
+private:
+    static QAtomicInt s_memoryMapping;
+};
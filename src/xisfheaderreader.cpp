@@ -1,240 +1,85 @@
 #include "xisfheaderreader.h"
+#include "xisfheaderengine.h"
+#include "framekeywordschema.h"
 #include "debuglogger.h"
-#include <QFile>
 #include <QFileInfo>
 #include <QDateTime>
-#include <QXmlStreamReader>
-#include <cmath>
 
-std::optional<XisfFrameData> XisfHeaderReader::read(const QString &path)
+// Two ASCII digits at s[i], or -1.
+static int twoDigits(QStringView s, qsizetype i)
 {
-    auto &dbg = DebugLogger::instance();
-    const bool logging = dbg.isSessionActive();
-
-    QFile f(path);
-    if (!f.open(QIODevice::ReadOnly)) {
-        if (logging)
-            dbg.logWarning(QStringLiteral("XISF: cannot open '%1'")
-                               .arg(QFileInfo(path).fileName()));
-        return std::nullopt;
-    }
+    const char16_t a = s[i].unicode(), b = s[i + 1].unicode();
+    if (a < u'0' || a > u'9' || b < u'0' || b > u'9') return -1;
+    return (a - u'0') * 10 + (b - u'0');
+}
 
-    const QByteArray magic = f.read(8);
-    if (!magic.startsWith("XISF0100")) {
-        if (logging)
-            dbg.logWarning(QStringLiteral("XISF: bad magic bytes in '%1'")
-                               .arg(QFileInfo(path).fileName()));
-        return std::nullopt;
+QDate XisfHeaderReader::observingNight(QStringView isoDateTime)
+{
+    // Fast path for the fixed "YYYY-MM-DDTHH:MM:SS[.fff]" layout written
+    // by acquisition software; anything after the seconds is ignored.
+    const QStringView s = isoDateTime;
+    if (s.size() >= 19 && s[4] == u'-' && s[7] == u'-'
+            && (s[10] == u'T' || s[10] == u' ')
+            && s[13] == u':' && s[16] == u':') {
+        const int c = twoDigits(s, 0), y = twoDigits(s, 2);
+        const int mo = twoDigits(s, 5), d = twoDigits(s, 8);
+        const int h = twoDigits(s, 11);
+        if (c >= 0 && y >= 0 && mo >= 0 && d >= 0 && h >= 0
+                && twoDigits(s, 14) >= 0 && twoDigits(s, 17) >= 0) {
+            const QDate date(c * 100 + y, mo, d);
+            if (date.isValid() && h < 24)
+                return h < 12 ? date.addDays(-1) : date;
+        }
     }
 
-    const QByteArray lenBytes = f.read(4);
-    if (lenBytes.size() < 4)
-        return std::nullopt;
-
-    const quint32 xmlLen =
-        static_cast<quint8>(lenBytes[0])         |
-        (static_cast<quint8>(lenBytes[1]) <<  8) |
-        (static_cast<quint8>(lenBytes[2]) << 16) |
-        (static_cast<quint8>(lenBytes[3]) << 24);
+    const QString str = s.toString();
+    QDateTime dt = QDateTime::fromString(str, Qt::ISODateWithMs);
+    if (!dt.isValid()) dt = QDateTime::fromString(str, Qt::ISODate);
+    return dt.isValid() ? dt.addSecs(-12 * 3600).date() : QDate();
+}
 
-    f.read(4);  // skip reserved bytes
+std::optional<XisfFrameData> XisfHeaderReader::read(const QString    &path,
+                                                    const QByteArray &prefetched)
+{
+    using namespace FrameKeywordSchema;
 
-    if (xmlLen == 0 || xmlLen > 10 * 1024 * 1024)
-        return std::nullopt;
+    auto &dbg = DebugLogger::instance();
+    const bool logging = dbg.isSessionActive();
 
-    const QByteArray xmlData = f.read(xmlLen);
-    if (static_cast<quint32>(xmlData.size()) < xmlLen)
-        return std::nullopt;
+    // Schema rows read from XISF frames, in schema order.
+    static const QStringList kNames = [] {
+        QStringList names;
+        for (int i = 0; i < kXisfEntryCount; ++i)
+            names << QString::fromLatin1(kEntries[i].name.data(),
+                                         qsizetype(kEntries[i].name.size()));
+        return names;
+    }();
 
-    static const QString kDateLoc  = QStringLiteral("DATE-LOC");
-    static const QString kGain     = QStringLiteral("GAIN");
-    static const QString kSetTemp  = QStringLiteral("SET-TEMP");
-    static const QString kFilter   = QStringLiteral("FILTER");
-    static const QString kObject   = QStringLiteral("OBJECT");
-    static const QString kAmbTemp  = QStringLiteral("AMBTEMP");
-    static const QString kXBinning = QStringLiteral("XBINNING");
+    XisfHeaderQuery query;
+    query.keywords     = kNames;
+    query.keywordIndex = &xisfIndexOf;
 
     if (logging)
         dbg.logDecision(
             QStringLiteral("XISF '%1': scanning for keywords [%2]")
-                .arg(QFileInfo(path).fileName(),
-                     QStringList{kDateLoc, kGain, kSetTemp,
-                                 kFilter, kObject, kAmbTemp,
-                                 kXBinning}.join(", ")));
-
-    QString dateLoc, gainRaw, setTempRaw, filterRaw, objectRaw,
-            ambTempRaw, xBinningRaw;
-
-    QXmlStreamReader xml(xmlData);
-    while (!xml.atEnd() && !xml.hasError()) {
-        if (xml.readNext() == QXmlStreamReader::StartElement
-            && xml.name() == QLatin1String("FITSKeyword")) {
+                .arg(QFileInfo(path).fileName(), kNames.join(", ")));
 
-            const QString name = xml.attributes().value(
-                QLatin1String("name")).toString().trimmed().toUpper();
-            const QString value = xml.attributes().value(
-                QLatin1String("value")).toString().trimmed();
-
-            if      (name == kDateLoc  && dateLoc.isEmpty())
-                dateLoc = value;
-            else if (name == kGain     && gainRaw.isEmpty())
-                gainRaw = value;
-            else if (name == kSetTemp  && setTempRaw.isEmpty())
-                setTempRaw = value;
-            else if (name == kFilter   && filterRaw.isEmpty())
-                filterRaw = value;
-            else if (name == kObject   && objectRaw.isEmpty())
-                objectRaw = value;
-            else if (name == kAmbTemp  && ambTempRaw.isEmpty())
-                ambTempRaw = value;
-            else if (name == kXBinning && xBinningRaw.isEmpty())
-                xBinningRaw = value;
-
-            if (!dateLoc.isEmpty()   && !gainRaw.isEmpty()   &&
-                !setTempRaw.isEmpty()&& !filterRaw.isEmpty() &&
-                !objectRaw.isEmpty() && !ambTempRaw.isEmpty()&&
-                !xBinningRaw.isEmpty())
-                break;
-        }
-    }
+    const auto header = XisfHeaderEngine::read(path, query, prefetched);
+    if (!header)
+        return std::nullopt;
 
-    if (logging) {
-        auto report = [&](const QString &kw, const QString &raw) {
-            if (raw.isEmpty())
-                dbg.logPattern(kw,
-                    QStringLiteral("FITSKeyword name=\"%1\"").arg(kw),
-                    false);
-            else
-                dbg.logPattern(kw,
-                    QStringLiteral("FITSKeyword name=\"%1\"").arg(kw),
-                    true, raw.left(80));
-        };
-        report(kDateLoc,  dateLoc);
-        report(kGain,     gainRaw);
-        report(kSetTemp,  setTempRaw);
-        report(kFilter,   filterRaw);
-        report(kObject,   objectRaw);
-        report(kAmbTemp,  ambTempRaw);
-        report(kXBinning, xBinningRaw);
-    }
+    RawValues raw;
+    for (int i = 0; i < kXisfEntryCount; ++i)
+        raw[i] = header->keywords.value(kNames.at(i));
 
-    if (dateLoc.isEmpty()) {
+    XisfFrameData result;
+    if (!apply(raw, kXisfEntryCount, result,
+               QStringLiteral("XISF '%1'").arg(QFileInfo(path).fileName()))) {
         if (logging)
             dbg.logWarning(
                 QStringLiteral("XISF '%1': DATE-LOC absent — frame skipped")
                     .arg(QFileInfo(path).fileName()));
         return std::nullopt;
     }
-
-    XisfFrameData result;
-
-    // ── DATE-LOC → observing night date ──────────────────────────────────
-    QString ds = dateLoc;
-    if (ds.startsWith('\'')) ds = ds.mid(1);
-    if (ds.endsWith('\''))   ds.chop(1);
-    ds = ds.trimmed();
-
-    QDateTime dt = QDateTime::fromString(ds, Qt::ISODateWithMs);
-    if (!dt.isValid()) dt = QDateTime::fromString(ds, Qt::ISODate);
-    if (dt.isValid()) {
-        dt = dt.addSecs(-12 * 3600);
-        result.date = dt.date();
-        if (logging)
-            dbg.logResult(
-                QStringLiteral("XISF '%1' date").arg(QFileInfo(path).fileName()),
-                result.date.toString(Qt::ISODate));
-    } else {
-        if (logging)
-            dbg.logWarning(
-                QStringLiteral("XISF '%1': could not parse DATE-LOC '%2'")
-                    .arg(QFileInfo(path).fileName(), ds));
-    }
-
-    // ── Helper: strip surrounding single-quotes ───────────────────────────
-    auto stripQuotes = [](const QString &s) -> QString {
-        QString t = s.trimmed();
-        if (t.startsWith('\'')) t = t.mid(1);
-        if (t.endsWith('\''))   t.chop(1);
-        return t.trimmed();
-    };
-
-    // ── GAIN ─────────────────────────────────────────────────────────────
-    if (!gainRaw.isEmpty()) {
-        bool ok = false;
-        double v = stripQuotes(gainRaw).toDouble(&ok);
-        if (ok) {
-            result.gain = static_cast<int>(std::round(v));
-            if (logging)
-                dbg.logResult(
-                    QStringLiteral("XISF '%1' gain")
-                        .arg(QFileInfo(path).fileName()),
-                    QString::number(result.gain));
-        }
-    }
-
-    // ── SET-TEMP ─────────────────────────────────────────────────────────
-    if (!setTempRaw.isEmpty()) {
-        bool ok = false;
-        double v = stripQuotes(setTempRaw).toDouble(&ok);
-        if (ok) {
-            result.sensorTemp    = static_cast<int>(std::round(v));
-            result.hasSensorTemp = true;
-            if (logging)
-                dbg.logResult(
-                    QStringLiteral("XISF '%1' SET-TEMP")
-                        .arg(QFileInfo(path).fileName()),
-                    QString::number(result.sensorTemp));
-        }
-    }
-
-    // ── FILTER ───────────────────────────────────────────────────────────
-    if (!filterRaw.isEmpty()) {
-        result.filter = stripQuotes(filterRaw);
-        if (logging)
-            dbg.logResult(
-                QStringLiteral("XISF '%1' FILTER")
-                    .arg(QFileInfo(path).fileName()),
-                result.filter);
-    }
-
-    // ── OBJECT ───────────────────────────────────────────────────────────
-    if (!objectRaw.isEmpty()) {
-        result.object = stripQuotes(objectRaw);
-        if (logging)
-            dbg.logResult(
-                QStringLiteral("XISF '%1' OBJECT")
-                    .arg(QFileInfo(path).fileName()),
-                result.object);
-    }
-
-    // ── AMBTEMP ──────────────────────────────────────────────────────────
-    if (!ambTempRaw.isEmpty()) {
-        bool ok = false;
-        double v = stripQuotes(ambTempRaw).toDouble(&ok);
-        if (ok) {
-            result.ambTemp    = v;
-            result.hasAmbTemp = true;
-            if (logging)
-                dbg.logResult(
-                    QStringLiteral("XISF '%1' AMBTEMP")
-                        .arg(QFileInfo(path).fileName()),
-                    QString::number(result.ambTemp, 'f', 2));
-        }
-    }
-
-    // ── XBINNING ─────────────────────────────────────────────────────────
-    if (!xBinningRaw.isEmpty()) {
-        bool ok = false;
-        int v = stripQuotes(xBinningRaw).toInt(&ok);
-        if (ok && v > 0) {
-            result.binning = v;
-            if (logging)
-                dbg.logResult(
-                    QStringLiteral("XISF '%1' XBINNING")
-                        .arg(QFileInfo(path).fileName()),
-                    QString::number(result.binning));
-        }
-    }
-
     return result;
 }
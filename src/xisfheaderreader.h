@@ -1,4 +1,5 @@
 #pragma once
+#include <QByteArray>
 #include <QString>
 #include <QDate>
 #include <optional>
@@ -13,9 +14,22 @@ struct XisfFrameData {
     int     binning{1};        // from XBINNING keyword; defaults to 1
     QString filter;            // FILTER keyword value, empty if absent
     QString object;            // OBJECT keyword value, empty if absent
+    double  exposureSec{0};    // EXPTIME (EXPOSURE in FITS), 0 if absent
+    int     iso{-1};           // ISO (DSLR frames)
+    bool    hasIso{false};
+    double  fNumber{-1};       // FOCRATIO
+    bool    hasFNumber{false};
 };
 
+// Which keyword fills which field is declared in framekeywordschema.h.
+
 class XisfHeaderReader {
 public:
-    static std::optional<XisfFrameData> read(const QString &path);
+    // prefetched: see XisfHeaderEngine::read().
+    static std::optional<XisfFrameData> read(const QString    &path,
+                                             const QByteArray &prefetched = {});
+
+    // Observing night of a DATE-LOC timestamp: the calendar date 12 hours
+    // earlier.  Invalid if the text is not an ISO 8601 date/time.
+    static QDate observingNight(QStringView isoDateTime);
 };
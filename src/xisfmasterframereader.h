@@ -3,15 +3,15 @@
 #include <optional>
 
 // Reads the integrated-frame count from a PixInsight master dark or flat .xisf.
-// Supports two formats:
-//   New PI: <table id="images" rows="N"> in the XML header block
+// Supports two formats, whichever comes first in the file:
+//   New PI: <table id="images" rows="N"> in the XML header block, either
+//           literal or inside the PixInsight:ProcessingHistory property,
+//           inline or attached
 //   Old PI: FITSKeyword HISTORY comment="ImageIntegration.numberOfImages: N"
 //
-// Reads at most kScanBytes from the file.
+// A query against XisfHeaderEngine, which bounds how much of the file is read.
 class XisfMasterFrameReader {
 public:
-    static constexpr qint64 kScanBytes = 256 * 1024;  // 256 KB
-
     // Returns the frame count, or nullopt if not found / file unreadable.
     static std::optional<int> readFrameCount(const QString &path);
 };